@@ -3,8 +3,66 @@
 #include <vector>
 #include <algorithm>
 #include <numeric>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <unordered_map>
 #include "../include/engine.hpp"
+#include "../include/sharded_engine.hpp"
+
+// Every global operator new is counted so each case can report heap
+// allocations per order. The counter is a plain increment, cheap enough to
+// leave on for the latency runs too. Every form of new and delete is
+// replaced, so nothing reaches the library's own pair. malloc and free stay
+// behind noinline calls: GCC pairs an inlined free with the new it came from
+// and warns (-Wmismatched-new-delete) though the two match.
+static size_t g_allocs = 0;
+
+__attribute__((noinline)) static void* counted_alloc(size_t size, size_t align) {
+    ++g_allocs;
+    if (size == 0) size = 1;
+    if (align <= alignof(std::max_align_t)) return std::malloc(size);
+    return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+__attribute__((noinline)) static void counted_free(void* p) { std::free(p); }
+
+static void* counted_new(size_t size, size_t align = 0) {
+    if (void* p = counted_alloc(size, align)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size)                                   { return counted_new(size); }
+void* operator new[](size_t size)                                 { return counted_new(size); }
+void* operator new(size_t size, std::align_val_t al)              { return counted_new(size, (size_t)al); }
+void* operator new[](size_t size, std::align_val_t al)            { return counted_new(size, (size_t)al); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept   { return counted_alloc(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size, 0); }
+void* operator new(size_t size, std::align_val_t al, const std::nothrow_t&) noexcept   { return counted_alloc(size, (size_t)al); }
+void* operator new[](size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return counted_alloc(size, (size_t)al); }
+
+void operator delete(void* p) noexcept                                             { counted_free(p); }
+void operator delete[](void* p) noexcept                                           { counted_free(p); }
+void operator delete(void* p, size_t) noexcept                                     { counted_free(p); }
+void operator delete[](void* p, size_t) noexcept                                   { counted_free(p); }
+void operator delete(void* p, std::align_val_t) noexcept                           { counted_free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept                         { counted_free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept                   { counted_free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept                 { counted_free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept                      { counted_free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept                    { counted_free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept    { counted_free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept  { counted_free(p); }
 
 static uint64_t next_id() {
     static uint64_t id = 1;
@@ -19,16 +77,37 @@ static uint64_t now_ns() {
 
 static Order make_order(Side side, OrderType type, double price, uint32_t qty) {
     return Order{
-        .order_id  = next_id(),
-        .timestamp = now_ns(),
-        .price     = price,
-        .quantity  = qty,
-        .side      = side,
-        .type      = type
+        .order_id         = next_id(),
+        .price            = to_fixed(price),
+        .quantity         = qty,
+        .side             = side,
+        .type             = type,
+        .display_quantity = 0,
+        .timestamp        = now_ns()
     };
 }
 
-void print_stats(const std::string& label, std::vector<uint64_t>& latencies, uint64_t total_ns, size_t count) {
+struct BenchResult {
+    std::string label;
+    double      throughput;
+    uint64_t    median;
+    uint64_t    p99;
+    uint64_t    p999;
+    double      allocs_per_order;
+};
+
+static const char* mode_name(BookMode mode) {
+    return mode == BookMode::LADDER ? "ladder" : "map";
+}
+
+// AAPL gets a tick ladder wide enough for every price the benches use;
+// in MAP mode it is created lazily by the first submit.
+static void setup_symbol(Engine& engine, BookMode mode) {
+    if (mode == BookMode::LADDER)
+        engine.add_symbol("AAPL", InstrumentConfig{.tick_size = to_fixed(0.01), .min_price = 0, .max_price = to_fixed(250.0)});
+}
+
+BenchResult print_stats(const std::string& label, BookMode mode, std::vector<uint64_t>& latencies, uint64_t total_ns, size_t count, size_t allocs) {
     std::sort(latencies.begin(), latencies.end());
 
     uint64_t min_lat    = latencies.front();
@@ -38,8 +117,9 @@ void print_stats(const std::string& label, std::vector<uint64_t>& latencies, uin
     uint64_t p999       = latencies[latencies.size() * 999 / 1000];
     double   avg        = (double)std::accumulate(latencies.begin(), latencies.end(), 0ULL) / count;
     double   throughput = (double)count / ((double)total_ns / 1e9);
+    double   per_order  = (double)allocs / count;
 
-    std::cout << "\n--- " << label << " ---\n";
+    std::cout << "\n--- " << label << " [" << mode_name(mode) << "] ---\n";
     std::cout << "  orders          : " << count << "\n";
     std::cout << "  total time      : " << std::fixed << std::setprecision(3) << (double)total_ns / 1e6 << " ms\n";
     std::cout << "  throughput      : " << std::fixed << std::setprecision(0) << throughput << " orders/sec\n";
@@ -49,14 +129,19 @@ void print_stats(const std::string& label, std::vector<uint64_t>& latencies, uin
     std::cout << "  latency p99     : " << p99 << " ns\n";
     std::cout << "  latency p99.9   : " << p999 << " ns\n";
     std::cout << "  latency max     : " << max_lat << " ns\n";
+    std::cout << "  allocs / order  : " << std::fixed << std::setprecision(3) << per_order << "\n";
+
+    return BenchResult{label, throughput, median, p99, p999, per_order};
 }
 
-void bench_limit_no_match(size_t n) {
+BenchResult bench_limit_no_match(size_t n, BookMode mode) {
     Engine engine;
+    setup_symbol(engine, mode);
     std::vector<uint64_t> latencies;
     latencies.reserve(n);
 
-    uint64_t start = now_ns();
+    uint64_t start  = now_ns();
+    size_t   allocs = g_allocs;
     for (size_t i = 0; i < n; i++) {
         double price = 100.0 + (i % 50);
         Side side    = (i % 2 == 0) ? Side::BUY : Side::SELL;
@@ -71,12 +156,14 @@ void bench_limit_no_match(size_t n) {
         latencies.push_back(t1 - t0);
     }
     uint64_t total = now_ns() - start;
+    allocs = g_allocs - allocs;
 
-    print_stats("LIMIT ORDERS (no match, building book)", latencies, total, n);
+    return print_stats("LIMIT ORDERS (no match, building book)", mode, latencies, total, n, allocs);
 }
 
-void bench_limit_with_match(size_t n) {
+BenchResult bench_limit_with_match(size_t n, BookMode mode) {
     Engine engine;
+    setup_symbol(engine, mode);
     std::vector<uint64_t> latencies;
     latencies.reserve(n);
 
@@ -85,7 +172,8 @@ void bench_limit_with_match(size_t n) {
         engine.submit("AAPL", make_order(Side::SELL, OrderType::LIMIT, price, 10000));
     }
 
-    uint64_t start = now_ns();
+    uint64_t start  = now_ns();
+    size_t   allocs = g_allocs;
     for (size_t i = 0; i < n; i++) {
         double price = 100.0 + (i % 20);
 
@@ -96,12 +184,14 @@ void bench_limit_with_match(size_t n) {
         latencies.push_back(t1 - t0);
     }
     uint64_t total = now_ns() - start;
+    allocs = g_allocs - allocs;
 
-    print_stats("LIMIT ORDERS (matching against resting asks)", latencies, total, n);
+    return print_stats("LIMIT ORDERS (matching against resting asks)", mode, latencies, total, n, allocs);
 }
 
-void bench_market_orders(size_t n) {
+BenchResult bench_market_orders(size_t n, BookMode mode) {
     Engine engine;
+    setup_symbol(engine, mode);
     std::vector<uint64_t> latencies;
     latencies.reserve(n);
 
@@ -110,7 +200,8 @@ void bench_market_orders(size_t n) {
         engine.submit("AAPL", make_order(Side::SELL, OrderType::LIMIT, price, 100000));
     }
 
-    uint64_t start = now_ns();
+    uint64_t start  = now_ns();
+    size_t   allocs = g_allocs;
     for (size_t i = 0; i < n; i++) {
         uint64_t t0 = now_ns();
         engine.submit("AAPL", make_order(Side::BUY, OrderType::MARKET, 0.0, 10));
@@ -119,12 +210,14 @@ void bench_market_orders(size_t n) {
         latencies.push_back(t1 - t0);
     }
     uint64_t total = now_ns() - start;
+    allocs = g_allocs - allocs;
 
-    print_stats("MARKET ORDERS (immediate execution)", latencies, total, n);
+    return print_stats("MARKET ORDERS (immediate execution)", mode, latencies, total, n, allocs);
 }
 
-void bench_cancel_orders(size_t n) {
+BenchResult bench_cancel_orders(size_t n, BookMode mode) {
     Engine engine;
+    setup_symbol(engine, mode);
     std::vector<uint64_t> latencies;
     std::vector<uint64_t> ids;
     latencies.reserve(n);
@@ -137,7 +230,8 @@ void bench_cancel_orders(size_t n) {
         engine.submit("AAPL", o);
     }
 
-    uint64_t start = now_ns();
+    uint64_t start  = now_ns();
+    size_t   allocs = g_allocs;
     for (size_t i = 0; i < n; i++) {
         uint64_t t0 = now_ns();
         engine.cancel("AAPL", ids[i]);
@@ -146,12 +240,14 @@ void bench_cancel_orders(size_t n) {
         latencies.push_back(t1 - t0);
     }
     uint64_t total = now_ns() - start;
+    allocs = g_allocs - allocs;
 
-    print_stats("CANCEL ORDERS (O(1) cancel from live book)", latencies, total, n);
+    return print_stats("CANCEL ORDERS (O(1) cancel from live book)", mode, latencies, total, n, allocs);
 }
 
-void bench_mixed_workload(size_t n) {
+BenchResult bench_mixed_workload(size_t n, BookMode mode) {
     Engine engine;
+    setup_symbol(engine, mode);
     std::vector<uint64_t> latencies;
     std::vector<uint64_t> live_ids;
     latencies.reserve(n);
@@ -161,7 +257,8 @@ void bench_mixed_workload(size_t n) {
         engine.submit("AAPL", make_order(Side::SELL, OrderType::LIMIT, price, 50000));
     }
 
-    uint64_t start = now_ns();
+    uint64_t start  = now_ns();
+    size_t   allocs = g_allocs;
     for (size_t i = 0; i < n; i++) {
         uint64_t t0 = now_ns();
 
@@ -186,23 +283,861 @@ void bench_mixed_workload(size_t n) {
         latencies.push_back(t1 - t0);
     }
     uint64_t total = now_ns() - start;
+    allocs = g_allocs - allocs;
+
+    return print_stats("MIXED WORKLOAD (40% rest, 30% match, 20% market, 10% cancel)", mode, latencies, total, n, allocs);
+}
+
+// Fill-heavy: four resting asks are re-seeded untimed before every aggressive
+// buy, so each timed submit produces exactly four fills.
+template<bool UseSink>
+BenchResult bench_fills(size_t n, BookMode mode) {
+    Engine engine;
+    setup_symbol(engine, mode);
+    std::vector<uint64_t> latencies;
+    latencies.reserve(n);
+
+    Trade    fills[16];
+    size_t   fill_count = 0;
+    uint64_t filled_qty = 0;
+    auto on_trade = [&](const Trade& t) { fills[fill_count++ & 15] = t; };
+
+    uint64_t elapsed = 0;
+    size_t   allocs  = 0;
+    for (size_t i = 0; i < n; i++) {
+        for (int k = 0; k < 4; k++)
+            engine.submit("AAPL", make_order(Side::SELL, OrderType::LIMIT, 100.0 + k, 10), on_trade);
+        Order buy = make_order(Side::BUY, OrderType::LIMIT, 103.0, 40);
+
+        size_t   a0 = g_allocs;
+        uint64_t t0 = now_ns();
+        if constexpr (UseSink) {
+            engine.submit("AAPL", buy, on_trade);
+        } else {
+            for (const Trade& t : engine.submit("AAPL", buy)) filled_qty += t.quantity;
+        }
+        uint64_t t1 = now_ns();
+        allocs += g_allocs - a0;
+
+        latencies.push_back(t1 - t0);
+        elapsed += t1 - t0;
+    }
+    filled_qty += fill_count;
+
+    return print_stats(UseSink ? "FILL-HEAVY, TradeSink (4 fills/order)"
+                               : "FILL-HEAVY, vector<Trade> (4 fills/order)",
+                       mode, latencies, elapsed, n, allocs);
+}
+
+// Aggregate throughput of ShardedEngine across a 5k-instrument universe. The
+// main thread produces, a second thread drains execution reports, and the
+// clock stops once every shard has drained its inbound ring.
+// One iceberg sell of 40 showing 10 at a time, swept by a FOK buy: the
+// feasibility check plus four fills, three of them replenishing the node.
+BenchResult bench_iceberg_fok(size_t n, BookMode mode) {
+    Engine engine;
+    setup_symbol(engine, mode);
+    InstrumentId aapl = engine.intern("AAPL");
+    std::vector<uint64_t> latencies;
+    latencies.reserve(n);
+
+    uint64_t filled   = 0;
+    auto     on_trade = [&](const Trade& t) { filled += t.quantity; };
+
+    uint64_t elapsed = 0;
+    size_t   allocs  = 0;
+    for (size_t i = 0; i < n; i++) {
+        Order iceberg = make_order(Side::SELL, OrderType::LIMIT, 100.0, 40);
+        iceberg.display_quantity = 10;
+        engine.submit(aapl, iceberg, on_trade);
+        Order buy = make_order(Side::BUY, OrderType::LIMIT, 100.0, 40);
+        buy.tif   = TimeInForce::FOK;
+
+        size_t   a0 = g_allocs;
+        uint64_t t0 = now_ns();
+        engine.submit(aapl, buy, on_trade);
+        uint64_t t1 = now_ns();
+        allocs += g_allocs - a0;
+
+        latencies.push_back(t1 - t0);
+        elapsed += t1 - t0;
+    }
+
+    return print_stats("ICEBERG + FOK, TradeSink (4 slices/order)", mode, latencies, elapsed, n, allocs);
+}
+
+// A thin book after news: asks 2.00 apart, 200 empty ticks between levels on
+// the ladder. Each timed message empties the best level(s), either a market
+// buy sweeping three levels or a cancel of the lone order at the touch; the
+// emptied levels are refilled untimed.
+template<bool Cancel>
+BenchResult bench_sparse(size_t n, BookMode mode) {
+    Engine engine;
+    setup_symbol(engine, mode);
+    InstrumentId aapl = engine.intern("AAPL");
+    std::vector<uint64_t> latencies;
+    latencies.reserve(n);
+
+    std::vector<uint64_t> touch;  // order ids resting at the three best asks
+    for (int k = 0; k < 20; k++) {
+        Order ask = make_order(Side::SELL, OrderType::LIMIT, 100.0 + 2.0 * k, 100);
+        if (k < 3) touch.push_back(ask.order_id);
+        engine.submit(aapl, ask);
+    }
+
+    uint64_t filled   = 0;
+    auto     on_trade = [&](const Trade& t) { filled += t.quantity; };
+
+    uint64_t elapsed = 0;
+    size_t   allocs  = 0;
+    for (size_t i = 0; i < n; i++) {
+        Order buy = make_order(Side::BUY, OrderType::MARKET, 0.0, 300);
+
+        size_t   a0 = g_allocs;
+        uint64_t t0 = now_ns();
+        if constexpr (Cancel) engine.cancel(aapl, touch[0]);
+        else                  engine.submit(aapl, buy, on_trade);
+        uint64_t t1 = now_ns();
+        allocs += g_allocs - a0;
+
+        latencies.push_back(t1 - t0);
+        elapsed += t1 - t0;
+
+        for (int k = Cancel ? 0 : 2; k >= 0; k--) {
+            Order ask = make_order(Side::SELL, OrderType::LIMIT, 100.0 + 2.0 * k, 100);
+            touch[k]  = ask.order_id;
+            engine.submit(aapl, ask, on_trade);
+        }
+    }
+
+    return print_stats(Cancel ? "SPARSE BOOK, cancel empties the touch (200-tick gaps)"
+                              : "SPARSE BOOK, market sweep of 3 levels (200-tick gaps)",
+                       mode, latencies, elapsed, n, allocs);
+}
+
+// Market-maker style amends on a 100-level resting book: even iterations cut
+// quantity in place, odd ones move the order one tick. The baseline is the
+// cancel + new-order pair clients had to send before MODIFY existed.
+template<bool Native>
+BenchResult bench_amend(size_t n, BookMode mode) {
+    Engine engine;
+    setup_symbol(engine, mode);
+    InstrumentId aapl = engine.intern("AAPL");
+    std::vector<uint64_t> latencies;
+    std::vector<Order>    live;
+    latencies.reserve(n);
+    live.reserve(n);
+
+    for (size_t i = 0; i < n; i++) {
+        Order o = make_order(Side::BUY, OrderType::LIMIT, 50.0 + (i % 100), 1000);
+        live.push_back(o);
+        engine.submit(aapl, o);
+    }
+
+    uint64_t fills    = 0;
+    auto     on_trade = [&](const Trade&) { ++fills; };
+
+    uint64_t start  = now_ns();
+    size_t   allocs = g_allocs;
+    for (size_t i = 0; i < n; i++) {
+        Order& o = live[i];
+        Price    price    = (i & 1) ? o.price + to_fixed(0.01) : o.price;
+        uint64_t quantity = (i & 1) ? o.quantity : o.quantity - 100;
+
+        uint64_t t0 = now_ns();
+        if constexpr (Native) {
+            engine.modify(aapl, o.order_id, price, quantity, on_trade);
+        } else {
+            engine.cancel(aapl, o.order_id);
+            o = make_order(Side::BUY, OrderType::LIMIT, to_double(price), (uint32_t)quantity);
+            engine.submit(aapl, o, on_trade);
+        }
+        uint64_t t1 = now_ns();
+
+        latencies.push_back(t1 - t0);
+    }
+    uint64_t total = now_ns() - start;
+    allocs = g_allocs - allocs;
+
+    return print_stats(Native ? "AMEND, native modify (cut / 1-tick move)"
+                              : "AMEND, cancel + new order (cut / 1-tick move)",
+                       mode, latencies, total, n, allocs);
+}
+
+void bench_sharded(size_t n, size_t num_shards) {
+    const size_t universe = 5000;
+
+    ShardedEngine engine(num_shards, 1 << 14, 1);
+    std::vector<InstrumentId> ids;
+    for (size_t s = 0; s < universe; s++)
+        ids.push_back(engine.add_symbol("SYM" + std::to_string(s)));
+
+    std::vector<Order> flow;
+    flow.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        // alternate sides per symbol so roughly half the flow crosses
+        Side   side  = ((i / universe) % 2 == 0) ? Side::BUY : Side::SELL;
+        double price = 100.0 + (double)((i / universe) % 5);
+        flow.push_back(make_order(side, OrderType::LIMIT, price, 100));
+    }
+
+    std::atomic<bool> done{false};
+    size_t            reports = 0;
+    std::thread consumer([&] {
+        while (!done.load(std::memory_order_acquire))
+            reports += engine.poll([](const ExecutionReport&) {});
+        reports += engine.poll([](const ExecutionReport&) {});
+    });
+
+    engine.start();
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < n; i++)
+        engine.submit(ids[i % universe], flow[i]);
+    engine.stop();
+    uint64_t total = now_ns() - start;
+
+    done.store(true, std::memory_order_release);
+    consumer.join();
+
+    std::cout << "  " << std::setw(2) << num_shards << " shards : "
+              << std::setw(10) << std::fixed << std::setprecision(0)
+              << (double)n / ((double)total / 1e9) << " orders/sec   "
+              << reports << " fills\n";
+}
+
+// Pre-trade risk overhead: the same resting/crossing flow from 64 accounts with
+// no gate, with only the quantity check compiled in, and with every check.
+// Limits are generous, so every order is accepted and does the full work.
+template<uint32_t Checks>
+double risk_pass(const std::vector<Order>& flow, bool gated) {
+    Engine           engine;
+    RiskGate<Checks> gate;
+    setup_symbol(engine, BookMode::LADDER);
+    InstrumentId aapl = engine.intern("AAPL");
+
+    AccountLimits limits;
+    limits.max_order_quantity = 1000000;
+    limits.max_position       = 1LL << 40;
+    limits.max_notional       = 1e15;
+    limits.price_collar       = 0.5;
+    limits.max_messages       = 1u << 30;
+    for (uint32_t account = 0; account < 64; account++) gate.set_limits(account, limits);
+    if (gated) engine.set_risk(&gate);
+
+    uint64_t fills    = 0;
+    auto     on_trade = [&](const Trade&) { ++fills; };
+
+    uint64_t start = now_ns();
+    for (const Order& o : flow) engine.submit(aapl, o, on_trade);
+    return (double)(now_ns() - start) / flow.size();
+}
+
+void bench_risk(size_t n) {
+    std::vector<Order> flow;
+    flow.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        Side   side  = (i % 2 == 0) ? Side::BUY : Side::SELL;
+        double price = (side == Side::BUY) ? 99.0 + (i % 3) : 100.0 + (i % 3);
+        Order  o     = make_order(side, OrderType::LIMIT, price, 100);
+        o.account    = (uint32_t)(i % 64);
+        flow.push_back(o);
+    }
+
+    // best of 5 fresh engines each, the differences are a few ns
+    double none = 1e9, quantity = 1e9, all = 1e9;
+    for (int run = 0; run < 5; run++) {
+        none     = std::min(none,     risk_pass<0>(flow, false));
+        quantity = std::min(quantity, risk_pass<risk::MAX_QUANTITY>(flow, true));
+        all      = std::min(all,      risk_pass<risk::ALL>(flow, true));
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "  no gate                " << std::setw(7) << none << " ns/order\n"
+              << "  RiskGate<MAX_QUANTITY> " << std::setw(7) << quantity << " ns/order  (+" << quantity - none << ")\n"
+              << "  RiskGate<ALL>          " << std::setw(7) << all << " ns/order  (+" << all - none << ")\n";
+}
+
+static double tsc_read_ns() {
+    uint64_t start = now_ns();
+    uint64_t sink  = 0;
+    for (int i = 0; i < 1000000; i++) sink += tsc_now();
+    return (double)(now_ns() - start - (sink & 1)) / 1e6;
+}
+
+// Mixed flow on one ladder book with and without EngineMetrics attached. The
+// instrumented run is read by a second thread every millisecond, the way a
+// monitoring exporter would, and its final report is printed.
+double metrics_pass(const std::vector<Order>& flow, EngineMetrics* metrics) {
+    Engine engine;
+    setup_symbol(engine, BookMode::LADDER);
+    InstrumentId aapl = engine.intern("AAPL");
+    engine.set_metrics(metrics);
+
+    std::atomic<bool> done{false};
+    std::thread exporter;
+    if (metrics) {
+        exporter = std::thread([&] {
+            while (!done.load(std::memory_order_relaxed)) {
+                MetricsReport live = metrics->report();
+                (void)live;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    }
+
+    uint64_t fills    = 0;
+    auto     on_trade = [&](const Trade&) { ++fills; };
+
+    uint64_t start = now_ns();
+    for (const Order& o : flow) {
+        if (o.type == OrderType::CANCEL) engine.cancel(aapl, o.order_id);
+        else                             engine.submit(aapl, o, on_trade);
+    }
+    double per_order = (double)(now_ns() - start) / flow.size();
 
-    print_stats("MIXED WORKLOAD (40% rest, 30% match, 20% market, 10% cancel)", latencies, total, n);
+    done = true;
+    if (exporter.joinable()) exporter.join();
+    return per_order;
 }
 
-int main() {
+void bench_metrics(size_t n) {
+    std::vector<Order> flow;
+    std::vector<uint64_t> live;
+    flow.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        int roll = i % 10;
+        if (roll < 4) {
+            Order o = make_order(Side::BUY, OrderType::LIMIT, 90.0 + (i % 100) * 0.05, 100);
+            live.push_back(o.order_id);
+            flow.push_back(o);
+        } else if (roll < 7) {
+            flow.push_back(make_order(Side::SELL, OrderType::LIMIT, 90.0 + (i % 50) * 0.05, 100));
+        } else if (roll < 9 || live.empty()) {
+            flow.push_back(make_order(Side::SELL, OrderType::LIMIT, 101.0 + (i % 20) * 0.05, 100));
+        } else {
+            Order cancel{};
+            cancel.order_id = live[(i * 7) % live.size()];
+            cancel.type     = OrderType::CANCEL;
+            flow.push_back(cancel);
+        }
+    }
+
+    EngineMetrics every;         // every stage timed
+    EngineMetrics sampled(4);    // 1 in 16 timed, counters on every order
+    double off = 1e9, all = 1e9, some = 1e9;
+    for (int run = 0; run < 3; run++) {
+        off  = std::min(off,  metrics_pass(flow, nullptr));
+        all  = std::min(all,  metrics_pass(flow, &every));
+        some = std::min(some, metrics_pass(flow, &sampled));
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "  metrics off        " << std::setw(7) << off  << " ns/order\n"
+              << "  every order timed  " << std::setw(7) << all  << " ns/order  (+" << all - off << ")\n"
+              << "  1 in 16 timed      " << std::setw(7) << some << " ns/order  (+" << some - off << ")\n"
+              << "  (exporter thread reading every 1 ms; tsc read costs "
+              << std::setprecision(1) << tsc_read_ns() << " ns on this host)\n\n";
+    every.report().print(std::cout);
+}
+
+// One perf_event_open counter for this thread, user space only. Virtual
+// machines and containers often hide the PMU; the open then fails and the
+// counter reports the reason instead of a number.
+class PerfCounter {
+public:
+    PerfCounter(uint32_t type, uint64_t config) {
+        perf_event_attr attr{};
+        attr.size           = sizeof(attr);
+        attr.type           = type;
+        attr.config         = config;
+        attr.disabled       = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        fd_    = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        error_ = fd_ < 0 ? errno : 0;
+    }
+    ~PerfCounter() { if (fd_ >= 0) close(fd_); }
+
+    PerfCounter(const PerfCounter&)            = delete;
+    PerfCounter& operator=(const PerfCounter&) = delete;
+
+    bool ok() const { return fd_ >= 0; }
+    const char* error() const { return std::strerror(error_); }
+
+    void start() {
+        if (!ok()) return;
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    uint64_t stop() {
+        uint64_t value = 0;
+        if (!ok()) return 0;
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd_, &value, sizeof(value)) != sizeof(value)) return 0;
+        return value;
+    }
+
+private:
+    int fd_;
+    int error_;
+};
+
+// Branch behaviour of the matching core: the same flows as the latency table,
+// counted with hardware branch and branch-miss events per order. Task clock is
+// a software event and is reported even where the PMU is not exposed.
+void bench_branches(size_t n) {
+    struct Flow { const char* label; std::vector<Order> orders; };
+    std::vector<Flow> flows(3);
+
+    flows[0].label = "resting limits, both sides";
+    flows[1].label = "crossing limits, both sides";
+    flows[2].label = "limits + markets + cancels";
+    for (size_t i = 0; i < n; i++) {
+        Side side = (i % 2 == 0) ? Side::BUY : Side::SELL;
+        flows[0].orders.push_back(make_order(side, OrderType::LIMIT,
+                                             side == Side::BUY ? 90.0 + (i % 50) * 0.05 : 101.0 + (i % 50) * 0.05, 100));
+        flows[1].orders.push_back(make_order(side, OrderType::LIMIT,
+                                             side == Side::BUY ? 100.0 + (i % 3) * 0.05 : 99.9 + (i % 3) * 0.05, 100));
+
+        int roll = i % 10;
+        if (roll < 6) {
+            flows[2].orders.push_back(make_order(side, OrderType::LIMIT,
+                                                 side == Side::BUY ? 99.0 + (i % 20) * 0.05 : 99.5 + (i % 20) * 0.05, 100));
+        } else if (roll < 8) {
+            flows[2].orders.push_back(make_order(side, OrderType::MARKET, 0.0, 150));
+        } else {
+            Order cancel{};
+            cancel.order_id = flows[2].orders[(i * 7) % flows[2].orders.size()].order_id;
+            cancel.type     = OrderType::CANCEL;
+            flows[2].orders.push_back(cancel);
+        }
+    }
+
+    PerfCounter branches(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS);
+    PerfCounter misses(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    PerfCounter clock(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK);
+
+    if (!branches.ok()) std::cout << "  hardware counters n/a (" << branches.error() << ")\n";
+    std::cout << "  flow                          branches/order   misses/order   miss %   task ns/order\n";
+    for (const Flow& flow : flows) {
+        Engine engine;
+        setup_symbol(engine, BookMode::LADDER);
+        InstrumentId aapl = engine.intern("AAPL");
+        uint64_t fills    = 0;
+        auto     on_trade = [&](const Trade&) { ++fills; };
+
+        branches.start(); misses.start(); clock.start();
+        for (const Order& o : flow.orders) {
+            if (o.type == OrderType::CANCEL) engine.cancel(aapl, o.order_id);
+            else                             engine.submit(aapl, o, on_trade);
+        }
+        uint64_t task = clock.stop(), missed = misses.stop(), taken = branches.stop();
+        double   per  = (double)flow.orders.size();
+
+        std::cout << "  " << std::left << std::setw(30) << flow.label << std::right << std::fixed;
+        if (branches.ok() && misses.ok()) {
+            std::cout << std::setprecision(1) << std::setw(14) << taken / per
+                      << std::setprecision(2) << std::setw(15) << missed / per
+                      << std::setw(9) << (taken ? 100.0 * missed / taken : 0.0);
+        } else {
+            std::cout << std::setw(14) << "n/a" << std::setw(15) << "n/a" << std::setw(9) << "n/a";
+        }
+        std::cout << std::setprecision(1) << std::setw(16) << (clock.ok() ? task / per : 0.0) << "\n";
+    }
+}
+
+// Batch-size sweep over 64 symbols. The same flow goes through three paths:
+// the per-call string API returning a vector, the per-call id API with a
+// TradeSink, and submit_batch into a reused BatchResult.
+void bench_batch_sweep(size_t n) {
+    const size_t symbols = 64;
+
+    std::vector<std::string>  names;
+    std::vector<OrderMessage> flow;
+    for (size_t s = 0; s < symbols; s++) names.push_back("SYM" + std::to_string(s));
+    flow.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        InstrumentId id    = (InstrumentId)((i * 7) % symbols);
+        int          roll  = i % 10;
+        Side         side  = (roll < 5) ? Side::BUY : Side::SELL;
+        double       price = (side == Side::BUY) ? 99.0 + (i % 3) : 100.0 + (i % 3);
+        flow.push_back(OrderMessage{id, make_order(side, OrderType::LIMIT, price, 100)});
+    }
+
+    std::cout << "  batch   string+vector   id+sink   submit_batch   (ns/order)\n";
+    for (size_t batch : {1, 8, 32, 64, 128, 256}) {
+        uint64_t elapsed[3];
+        for (int path = 0; path < 3; path++) {
+            Engine engine;
+            for (const std::string& name : names) engine.intern(name);
+
+            BatchResult        result;
+            std::vector<Trade> trades;
+            trades.reserve(4 * batch);
+            result.trades.reserve(4 * batch);
+            uint64_t filled = 0;
+
+            uint64_t start = now_ns();
+            for (size_t i = 0; i + batch <= n; i += batch) {
+                if (path == 0) {
+                    for (size_t k = i; k < i + batch; k++)
+                        filled += engine.submit(names[flow[k].instrument], flow[k].order).size();
+                } else if (path == 1) {
+                    trades.clear();
+                    for (size_t k = i; k < i + batch; k++)
+                        engine.submit(flow[k].instrument, flow[k].order,
+                                      [&](const Trade& t) { trades.push_back(t); });
+                } else {
+                    engine.submit_batch(&flow[i], batch, result);
+                }
+            }
+            elapsed[path] = now_ns() - start;
+            (void)filled;
+        }
+        std::cout << "  " << std::setw(5) << batch << std::fixed << std::setprecision(1)
+                  << std::setw(16) << (double)elapsed[0] / n
+                  << std::setw(10) << (double)elapsed[1] / n
+                  << std::setw(15) << (double)elapsed[2] / n << "\n";
+    }
+}
+
+// Order-id index churn at a steady resting count: every step adds a new id,
+// looks up a live one and erases the oldest, as a book does under flow.
+// Reports ns per step, heap allocations per step and bytes per resting entry
+// (for unordered_map, buckets plus one malloc'd node per entry).
+template<typename Index>
+static void index_pass(const char* label, Index& index, size_t n, size_t resting,
+                       size_t (*bytes)(const Index&)) {
+    OrderNode node{};
+    for (uint64_t id = 1; id <= resting; id++) index.insert({id, &node});
+
+    size_t   allocs = g_allocs;
+    uint64_t found  = 0;
+    uint64_t start  = now_ns();
+    for (uint64_t id = resting + 1; id <= resting + n; id++) {
+        index.insert({id, &node});
+        found += index.find(id - resting / 2) != index.end();
+        index.erase(id - resting);
+    }
+    double per_step = (double)(now_ns() - start) / n;
+
+    std::cout << "  " << std::left << std::setw(20) << label << std::right << std::fixed
+              << std::setprecision(1) << std::setw(7) << per_step << " ns/step  "
+              << std::setprecision(2) << std::setw(5) << (double)(g_allocs - allocs) / n << " allocs/step  "
+              << std::setprecision(1) << std::setw(6) << (double)bytes(index) / index.size()
+              << " bytes/order" << (found == n ? "" : "  (lookup missed)") << "\n";
+}
+
+// adapts OrderIndex to the unordered_map calls index_pass makes
+struct FlatIndex {
+    OrderIndex index;
+    void   insert(std::pair<uint64_t, OrderNode*> e) { index.insert(e.first, e.second); }
+    auto   find(uint64_t id) const { return index.find(id); }
+    void   erase(uint64_t id) { index.erase(id); }
+    size_t size() const { return index.size(); }
+    OrderNode* end() const { return nullptr; }
+};
+
+void bench_order_index(size_t n) {
+    using Map = std::unordered_map<uint64_t, OrderNode*>;
+    for (size_t resting : {1000, 100000}) {
+        std::cout << "  " << resting << " resting\n";
+        Map map;
+        index_pass<Map>("  unordered_map", map, n, resting, [](const Map& m) {
+            return m.bucket_count() * sizeof(void*) + m.size() * 32;
+        });
+        FlatIndex flat;
+        index_pass<FlatIndex>("  OrderIndex", flat, n, resting, [](const FlatIndex& f) {
+            return f.index.memory_bytes();
+        });
+    }
+}
+
+// A market maker's 20k quotes among 100k resting orders of other owners, on
+// 500 ladder levels, pulled three ways: one Engine::cancel per id (the ids
+// the caller would have had to track), a mass cancel by owner tag, and a
+// whole-book mass cancel of all 100k. Best of 5 fresh books each.
+void bench_mass_cancel() {
+    const size_t   resting = 100000;
+    const uint32_t owner   = 7;
+
+    std::vector<uint64_t> quotes;  // the market maker's ids
+    auto fill_book = [&](Engine& engine) {
+        engine.add_symbol("NIFTY", InstrumentConfig{to_fixed(0.05), to_fixed(20000.0), to_fixed(24000.0)});
+        InstrumentId id = *engine.find_symbol("NIFTY");
+        engine.reserve(id, resting);
+        quotes.clear();
+        for (size_t i = 0; i < resting; i++) {
+            Side     side  = (i % 2 == 0) ? Side::BUY : Side::SELL;
+            uint64_t tag   = (i % 5 == 0) ? owner : 1 + i % 3;  // every fifth order is the maker's
+            Order    order = make_order(side, OrderType::LIMIT, side == Side::BUY ? 21999.95 - (double)(i % 500) * 0.05
+                                                                                  : 22000.00 + (double)(i % 500) * 0.05, 10);
+            order.order_id = (tag << OWNER_SHIFT) | order.order_id;
+            engine.submit(id, order);
+            if (tag == owner) quotes.push_back(order.order_id);
+        }
+        return id;
+    };
+
+    double one_by_one = 1e18, by_owner = 1e18, whole = 1e18;
+    for (int run = 0; run < 5; run++) {
+        {
+            Engine       engine;
+            InstrumentId id    = fill_book(engine);
+            uint64_t     start = now_ns();
+            for (uint64_t order_id : quotes) engine.cancel(id, order_id);
+            one_by_one = std::min(one_by_one, (double)(now_ns() - start));
+        }
+        {
+            Engine engine;
+            fill_book(engine);
+            uint64_t start = now_ns();
+            engine.mass_cancel(CancelFilter::owned_by(owner));
+            by_owner = std::min(by_owner, (double)(now_ns() - start));
+        }
+        {
+            Engine engine;
+            fill_book(engine);
+            uint64_t start = now_ns();
+            engine.mass_cancel(CancelFilter::all());
+            whole = std::min(whole, (double)(now_ns() - start));
+        }
+    }
+
+    const double maker = (double)quotes.size();
+    std::cout << std::fixed << std::setprecision(1)
+              << "  " << quotes.size() << " maker quotes, Engine::cancel per id " << std::setw(8) << one_by_one / 1000
+              << " us  (" << one_by_one / maker << " ns/order)\n"
+              << "  " << quotes.size() << " maker quotes, mass_cancel(owned_by) " << std::setw(8) << by_owner / 1000
+              << " us  (" << by_owner / maker << " ns/order)\n"
+              << "  " << resting << " orders, mass_cancel(all)          " << std::setw(8) << whole / 1000
+              << " us  (" << whole / (double)resting << " ns/order)\n";
+}
+
+// A 10k-deep stop cascade: every ask level holds 10 lots and a buy stop for
+// 10 lots waits on each level's price, so each elected stop lifts one level
+// and elects the next. One market order sets it off. The baseline submits the
+// same market orders directly, as a poller that saw each print would, minus
+// its round trip. Best of 5 fresh books each.
+void bench_stops() {
+    const int levels = 10000;
+
+    auto fill_book = [&](Engine& engine, bool stops) {
+        engine.add_symbol("NIFTY", InstrumentConfig{to_fixed(0.05), to_fixed(20000.0), to_fixed(24000.0)});
+        InstrumentId id = *engine.find_symbol("NIFTY");
+        engine.reserve(id, 2 * levels);
+        for (int i = 0; i < levels; i++) {
+            engine.submit(id, make_order(Side::SELL, OrderType::LIMIT, 22000.00 + i * 0.05, 10));
+            if (!stops) continue;
+            Order stop      = make_order(Side::BUY, OrderType::STOP, 0, 10);
+            stop.stop_price = to_fixed(22000.00 + i * 0.05);
+            engine.submit(id, stop);
+        }
+        return id;
+    };
+
+    double cascade = 1e18, direct = 1e18;
+    size_t fills   = 0;
+    for (int run = 0; run < 5; run++) {
+        {
+            Engine       engine;
+            InstrumentId id = fill_book(engine, true);
+            size_t       n  = 0;
+            uint64_t start  = now_ns();
+            engine.submit(id, make_order(Side::BUY, OrderType::MARKET, 0, 10), [&](const Trade&) { ++n; });
+            cascade = std::min(cascade, (double)(now_ns() - start));
+            fills   = n;
+        }
+        {
+            Engine       engine;
+            InstrumentId id = fill_book(engine, false);
+            auto on_trade = [](const Trade&) {};
+            uint64_t start = now_ns();
+            for (int i = 0; i <= levels; i++)
+                engine.submit(id, make_order(Side::BUY, OrderType::MARKET, 0, 10), on_trade);
+            direct = std::min(direct, (double)(now_ns() - start));
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "  cascade of " << levels << " stops  " << std::setw(8) << cascade / 1000 << " us  ("
+              << cascade / levels << " ns/stop, " << fills << " fills)\n"
+              << "  same orders submitted   " << std::setw(8) << direct / 1000 << " us  ("
+              << direct / levels << " ns/order)\n";
+}
+
+void bench_auction(size_t n) {
+    // two crossed ladders: buys and sells spread over the same 400 ticks
+    std::vector<Order> orders;
+    orders.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        Side side = (i % 2 == 0) ? Side::BUY : Side::SELL;
+        orders.push_back(make_order(side, OrderType::LIMIT, 21990.00 + (double)((i * 7919) % 400) * 0.05,
+                                    (uint32_t)(1 + (i * 31) % 100)));
+    }
+
+    struct Indications : BookListener {
+        size_t count = 0;
+        void on_auction(const AuctionIndication&) override { ++count; }
+    };
+
+    double queue = 1e18, indicate = 1e18, cross = 1e18, continuous = 1e18;
+    size_t fills = 0, published = 0, cross_fills = 0;
+    AuctionIndication at{};
+    for (int run = 0; run < 3; run++) {
+        {
+            Engine engine;
+            engine.add_symbol("NIFTY", InstrumentConfig{to_fixed(0.05), to_fixed(20000.0), to_fixed(24000.0)});
+            InstrumentId id = *engine.find_symbol("NIFTY");
+            engine.reserve(id, n);
+            Indications feed;
+            engine.set_listener(id, &feed);
+            AuctionOptions options;
+            options.reference      = to_fixed(22000.00);
+            options.indicate_every = 1000;
+            engine.begin_auction(id, options);
+
+            auto on_trade = [](const Trade&) {};
+            uint64_t start = now_ns();
+            for (const Order& order : orders) engine.submit(id, order, on_trade);
+            queue = std::min(queue, (double)(now_ns() - start));
+            published = feed.count;
+
+            start = now_ns();
+            for (int i = 0; i < 100; i++) at = engine.indicative(id);
+            indicate = std::min(indicate, (double)(now_ns() - start) / 100);
+
+            engine.set_listener(id, nullptr);
+            size_t f = 0;
+            start = now_ns();
+            engine.uncross(id, [&](const Trade&) { ++f; });
+            cross       = std::min(cross, (double)(now_ns() - start));
+            cross_fills = f;
+        }
+        {
+            Engine engine;
+            engine.add_symbol("NIFTY", InstrumentConfig{to_fixed(0.05), to_fixed(20000.0), to_fixed(24000.0)});
+            InstrumentId id = *engine.find_symbol("NIFTY");
+            engine.reserve(id, n);
+            size_t f = 0;
+            uint64_t start = now_ns();
+            for (const Order& order : orders) engine.submit(id, order, [&](const Trade&) { ++f; });
+            continuous = std::min(continuous, (double)(now_ns() - start));
+            fills      = f;
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "  queue in the call       " << std::setw(8) << queue / 1e6 << " ms  ("
+              << queue / (double)n << " ns/order, " << published << " indications published)\n"
+              << "  indicative()            " << std::setw(8) << indicate / 1000 << " us  ("
+              << to_double(at.price) << " x " << at.volume << ")\n"
+              << "  uncross                 " << std::setw(8) << cross / 1e6 << " ms  ("
+              << cross / (double)cross_fills << " ns/fill, " << cross_fills << " fills)\n"
+              << "  same orders continuous  " << std::setw(8) << continuous / 1e6 << " ms  ("
+              << continuous / (double)n << " ns/order, " << fills << " fills)\n";
+}
+
+int main(int argc, char** argv) {
     const size_t N = 500000;
 
+    // --alloc: summary table reports heap allocations per order instead of latency
+    const bool alloc_mode = (argc > 1 && std::strcmp(argv[1], "--alloc") == 0);
+
     std::cout << "========================================\n";
     std::cout << "  ORDERBOOK BENCHMARK\n";
     std::cout << "  " << N << " operations per test\n";
     std::cout << "========================================";
 
-    bench_limit_no_match(N);
-    bench_limit_with_match(N);
-    bench_market_orders(N);
-    bench_cancel_orders(N);
-    bench_mixed_workload(N);
+    using BenchFn = BenchResult (*)(size_t, BookMode);
+    const BenchFn benches[] = {
+        bench_limit_no_match,
+        bench_limit_with_match,
+        bench_market_orders,
+        bench_cancel_orders,
+        bench_mixed_workload,
+        bench_fills<false>,
+        bench_fills<true>,
+        bench_iceberg_fok,
+        bench_sparse<false>,
+        bench_sparse<true>,
+        bench_amend<false>,
+        bench_amend<true>,
+    };
+
+    std::vector<std::pair<BenchResult, BenchResult>> results;
+    for (BenchFn bench : benches) {
+        BenchResult map_result    = bench(N, BookMode::MAP);
+        BenchResult ladder_result = bench(N, BookMode::LADDER);
+        results.emplace_back(map_result, ladder_result);
+    }
+
+    std::cout << "\n========================================\n";
+    if (alloc_mode) std::cout << "  MAP vs LADDER (malloc calls per order)\n";
+    else            std::cout << "  MAP vs LADDER (median / p99 / p99.9 ns, orders/sec)\n";
+    std::cout << "========================================\n";
+    for (const auto& [map_result, ladder_result] : results) {
+        std::cout << "  " << map_result.label << "\n";
+        for (const BenchResult* r : {&map_result, &ladder_result}) {
+            std::cout << "    " << std::left << std::setw(8) << (r == &map_result ? "map" : "ladder") << std::right;
+            if (alloc_mode) {
+                std::cout << std::fixed << std::setprecision(3) << r->allocs_per_order << "\n";
+                continue;
+            }
+            std::cout << std::setw(6) << r->median << " / "
+                      << std::setw(6) << r->p99    << " / "
+                      << std::setw(6) << r->p999   << "   "
+                      << std::fixed << std::setprecision(0) << r->throughput << "\n";
+        }
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  PRE-TRADE RISK (ladder, 64 accounts, " << N << " orders)\n";
+    std::cout << "========================================\n";
+    bench_risk(N);
+
+    std::cout << "\n========================================\n";
+    std::cout << "  ENGINE METRICS (ladder, " << N << " mixed orders, 3 runs)\n";
+    std::cout << "========================================\n";
+    bench_metrics(N);
+
+    std::cout << "\n========================================\n";
+    std::cout << "  BATCH SUBMIT SWEEP (64 symbols, " << N << " orders)\n";
+    std::cout << "========================================\n";
+    bench_batch_sweep(N);
+
+    std::cout << "\n========================================\n";
+    std::cout << "  ORDER-ID INDEX (" << N << " add / find / erase steps)\n";
+    std::cout << "========================================\n";
+    bench_order_index(N);
+
+    std::cout << "\n========================================\n";
+    std::cout << "  MASS CANCEL (100000 resting on 500 ladder levels)\n";
+    std::cout << "========================================\n";
+    bench_mass_cancel();
+
+    std::cout << "\n========================================\n";
+    std::cout << "  STOP ORDERS (ladder, one market order sets off the cascade)\n";
+    std::cout << "========================================\n";
+    bench_stops();
+
+    std::cout << "\n========================================\n";
+    std::cout << "  CALL AUCTION (ladder, " << N << " crossed orders over 400 ticks)\n";
+    std::cout << "========================================\n";
+    bench_auction(N);
+
+    std::cout << "\n========================================\n";
+    std::cout << "  BRANCH BEHAVIOUR (ladder, " << N << " orders per flow)\n";
+    std::cout << "========================================\n";
+    bench_branches(N);
+
+    std::cout << "\n========================================\n";
+    std::cout << "  SHARDED ENGINE (5000 symbols, " << N << " orders, "
+              << std::thread::hardware_concurrency() << " cores)\n";
+    std::cout << "========================================\n";
+    for (size_t shards : {1, 2, 4, 8, 16})
+        bench_sharded(N, shards);
 
     std::cout << "\n========================================\n";
     std::cout << "  BENCHMARK COMPLETE\n";
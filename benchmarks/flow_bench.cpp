@@ -0,0 +1,239 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include "../include/engine.hpp"
+#include "../include/flow.hpp"
+#include "../include/metrics.hpp"
+
+// flowbench gen <out.flow> [--orders N] [--symbols N] [--zipf S] [--cancel R]
+//                          [--replace R] [--market R] [--cross R]
+//                          [--depth N] [--decay D] [--seed N]
+// flowbench run <flow> [--warmup N] [--core C] [--json path] [--csv path] [--label name]
+//
+// `gen` writes a seeded synthetic flow; `run` replays any journal-format file,
+// recorded or synthetic, through a fresh Engine and times every message. The
+// whole file is decoded before the clock starts, the first --warmup messages
+// are applied but not recorded, and the thread can be pinned to one core.
+// JSON keeps the full bucket list for plotting; CSV appends one row per
+// message kind so runs can be compared across commits.
+
+namespace {
+
+const char* const KINDS[] = {"all", "limit", "market", "cancel", "modify", "stop"};
+constexpr size_t  KIND_COUNT = sizeof(KINDS) / sizeof(KINDS[0]);
+
+size_t kind_of(OrderType type) {
+    switch (type) {
+        case OrderType::LIMIT:  return 1;
+        case OrderType::MARKET: return 2;
+        case OrderType::CANCEL: return 3;
+        case OrderType::MODIFY: return 4;
+        case OrderType::STOP:
+        case OrderType::STOP_LIMIT: return 5;
+    }
+    return 0;
+}
+
+uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// argv[first..] as --name value pairs
+struct Args {
+    std::vector<std::pair<std::string, std::string>> pairs;
+
+    Args(int argc, char** argv, int first) {
+        for (int i = first; i < argc; i += 2) {
+            if (std::strncmp(argv[i], "--", 2) != 0 || i + 1 >= argc)
+                throw std::invalid_argument(std::string("bad argument: ") + argv[i]);
+            pairs.emplace_back(argv[i] + 2, argv[i + 1]);
+        }
+    }
+
+    const char* get(const char* name) const {
+        for (auto& [key, value] : pairs)
+            if (key == name) return value.c_str();
+        return nullptr;
+    }
+
+    double      number(const char* name, double fallback) const { auto v = get(name); return v ? std::atof(v) : fallback; }
+    std::string text(const char* name, const std::string& fallback) const { auto v = get(name); return v ? v : fallback; }
+};
+
+int generate(const std::string& path, const Args& args) {
+    FlowProfile profile;
+    profile.orders        = (size_t)args.number("orders", (double)profile.orders);
+    profile.symbols       = (size_t)args.number("symbols", (double)profile.symbols);
+    profile.zipf_s        = args.number("zipf", profile.zipf_s);
+    profile.cancel_ratio  = args.number("cancel", profile.cancel_ratio);
+    profile.replace_ratio = args.number("replace", profile.replace_ratio);
+    profile.market_ratio  = args.number("market", profile.market_ratio);
+    profile.cross_ratio   = args.number("cross", profile.cross_ratio);
+    profile.depth_levels  = (uint32_t)args.number("depth", profile.depth_levels);
+    profile.depth_decay   = args.number("decay", profile.depth_decay);
+    profile.seed          = (uint64_t)args.number("seed", (double)profile.seed);
+
+    uint64_t start = now_ns();
+    size_t   count = generate_flow(profile, path);
+    std::cout << "  wrote " << count << " messages over " << profile.symbols << " symbols to " << path
+              << " in " << (now_ns() - start) / 1000000 << " ms\n";
+    return 0;
+}
+
+void pin_to(int core) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+        std::cerr << "  warning: could not pin to core " << core << "\n";
+}
+
+struct Summary {
+    HistogramSnapshot h;
+    double            ticks_per_ns;
+
+    uint64_t ns(uint64_t ticks) const { return (uint64_t)((double)ticks / ticks_per_ns + 0.5); }
+    uint64_t at(double p)       const { return ns(h.percentile(p)); }
+};
+
+void write_json(const std::string& path, const std::string& label, const std::string& flow,
+                size_t messages, size_t warmup, int core, double throughput, uint64_t trades,
+                const std::vector<Summary>& kinds) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("cannot open " + path);
+
+    out << std::fixed << std::setprecision(2);
+    out << "{\n  \"label\": \"" << label << "\",\n  \"flow\": \"" << flow << "\",\n"
+        << "  \"messages\": " << messages << ",\n  \"warmup\": " << warmup << ",\n"
+        << "  \"core\": " << core << ",\n  \"throughput\": " << throughput << ",\n"
+        << "  \"trades\": " << trades << ",\n  \"ticks_per_ns\": " << kinds[0].ticks_per_ns << ",\n"
+        << "  \"kinds\": {";
+
+    for (size_t k = 0; k < KIND_COUNT; k++) {
+        const Summary& s = kinds[k];
+        out << (k ? ",\n" : "\n") << "    \"" << KINDS[k] << "\": {\"count\": " << s.h.total
+            << ", \"mean_ns\": " << s.h.mean() / s.ticks_per_ns
+            << ", \"p50\": " << s.at(50) << ", \"p90\": " << s.at(90) << ", \"p99\": " << s.at(99)
+            << ", \"p99.9\": " << s.at(99.9) << ", \"p99.99\": " << s.at(99.99)
+            << ", \"max\": " << s.ns(s.h.max) << ", \"buckets\": [";
+
+        // [upper bound in ns, count] for each non-empty bucket
+        bool first = true;
+        for (size_t i = 0; i < s.h.counts.size(); i++) {
+            if (!s.h.counts[i]) continue;
+            out << (first ? "" : ", ") << "[" << (double)Histogram::highest_in(i) / s.ticks_per_ns
+                << ", " << s.h.counts[i] << "]";
+            first = false;
+        }
+        out << "]}";
+    }
+    out << "\n  }\n}\n";
+}
+
+void append_csv(const std::string& path, const std::string& label, double throughput,
+                const std::vector<Summary>& kinds) {
+    struct stat st;
+    bool fresh = (stat(path.c_str(), &st) != 0 || st.st_size == 0);
+
+    std::ofstream out(path, std::ios::app);
+    if (!out) throw std::runtime_error("cannot open " + path);
+
+    if (fresh) out << "label,kind,count,mean_ns,p50,p90,p99,p99.9,p99.99,max,throughput\n";
+    out << std::fixed << std::setprecision(2);
+    for (size_t k = 0; k < KIND_COUNT; k++) {
+        const Summary& s = kinds[k];
+        out << label << "," << KINDS[k] << "," << s.h.total << "," << s.h.mean() / s.ticks_per_ns << ","
+            << s.at(50) << "," << s.at(90) << "," << s.at(99) << "," << s.at(99.9) << ","
+            << s.at(99.99) << "," << s.ns(s.h.max) << "," << throughput << "\n";
+    }
+}
+
+int run(const std::string& path, const Args& args) {
+    const size_t      warmup = (size_t)args.number("warmup", 100000);
+    const int         core   = (int)args.number("core", -1);
+    const std::string label  = args.text("label", path);
+
+    if (core >= 0) pin_to(core);
+
+    // decode up front so file I/O and record parsing stay off the timed path
+    Engine                    engine;
+    std::vector<OrderMessage> messages = load_flow(path, engine);
+
+    std::vector<Histogram> histograms(KIND_COUNT);
+    uint64_t trades = 0;
+    auto     sink   = [&](const Trade&) { ++trades; };
+
+    for (size_t i = 0; i < messages.size() && i < warmup; i++) {
+        try { engine.submit(messages[i].instrument, messages[i].order, sink); }
+        catch (const std::out_of_range&) {}
+    }
+    trades = 0;
+
+    uint64_t start = now_ns();
+    for (size_t i = warmup; i < messages.size(); i++) {
+        const OrderMessage& m = messages[i];
+        uint64_t t0 = tsc_now();
+        try { engine.submit(m.instrument, m.order, sink); }
+        catch (const std::out_of_range&) {}
+        uint64_t ticks = tsc_now() - t0;
+        histograms[0].record(ticks);
+        histograms[kind_of(m.order.type)].record(ticks);
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    size_t timed      = messages.size() > warmup ? messages.size() - warmup : 0;
+    double throughput = elapsed ? (double)timed / ((double)elapsed / 1e9) : 0.0;
+
+    std::vector<Summary> kinds;
+    for (const Histogram& h : histograms) kinds.push_back(Summary{h.snapshot(), tsc_ticks_per_ns()});
+
+    std::cout << "  flow        : " << path << " (" << messages.size() << " messages, "
+              << engine.instrument_count() << " instruments)\n";
+    std::cout << "  timed       : " << timed << " after " << std::min(warmup, messages.size()) << " warm-up"
+              << (core >= 0 ? ", pinned to core " + std::to_string(core) : std::string()) << "\n";
+    std::cout << "  trades      : " << trades << "\n";
+    std::cout << "  throughput  : " << std::fixed << std::setprecision(0) << throughput << " msgs/sec\n\n";
+    std::cout << "  kind          count      p50      p90      p99    p99.9   p99.99      max   (ns)\n";
+    for (size_t k = 0; k < KIND_COUNT; k++) {
+        const Summary& s = kinds[k];
+        if (s.h.total == 0) continue;
+        std::cout << "  " << std::left << std::setw(8) << KINDS[k] << std::right
+                  << std::setw(11) << s.h.total
+                  << std::setw(9) << s.at(50) << std::setw(9) << s.at(90) << std::setw(9) << s.at(99)
+                  << std::setw(9) << s.at(99.9) << std::setw(9) << s.at(99.99)
+                  << std::setw(9) << s.ns(s.h.max) << "\n";
+    }
+
+    if (const char* json = args.get("json")) write_json(json, label, path, messages.size(), warmup, core, throughput, trades, kinds);
+    if (const char* csv  = args.get("csv"))  append_csv(csv, label, throughput, kinds);
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3 || (std::strcmp(argv[1], "gen") != 0 && std::strcmp(argv[1], "run") != 0)) {
+        std::cerr << "usage: " << argv[0] << " gen <out.flow> [--orders N] [--symbols N] [--zipf S] [--seed N] ...\n"
+                  << "       " << argv[0] << " run <flow> [--warmup N] [--core C] [--json path] [--csv path] [--label name]\n";
+        return 2;
+    }
+
+    try {
+        Args args(argc, argv, 3);
+        return std::strcmp(argv[1], "gen") == 0 ? generate(argv[2], args) : run(argv[2], args);
+    } catch (const std::exception& e) {
+        std::cerr << "flowbench: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "../include/flow.hpp"
+#include "../include/gateway.hpp"
+#include "../include/metrics.hpp"
+
+// loadgen <flow> [--unix path | --port P [--host H]] [--window W] [--warmup N] [--spin N]
+//
+// Sends every message of a flow file to a gateway and times each request from
+// just before its frame is written to the arrival of its ACK. --window bounds
+// the requests in flight: 1 is strict ping-pong, larger values pipeline. With
+// no address, loadgen starts its own Gateway in-process on a Unix socket, so
+// one command measures the whole socket -> ring -> engine -> socket path; to
+// measure across processes, start `gateway <flow>` and point loadgen at it.
+// --spin sets the in-process gateway's spin_polls; 0 parks at once, which is
+// what a host with fewer cores than busy threads needs and the default there.
+
+namespace {
+
+uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+struct Options {
+    std::string unix_path;
+    std::string host   = "127.0.0.1";
+    int         port   = -1;
+    size_t      window = 1;
+    size_t      warmup = 10000;
+    unsigned    spin   = std::thread::hardware_concurrency() >= 3 ? GatewayOptions{}.spin_polls : 0;
+};
+
+void send(GatewayClient& client, const OrderMessage& m) {
+    const Order& o = m.order;
+    switch (o.type) {
+        case OrderType::CANCEL: client.cancel(m.instrument, o.order_id, tsc_now()); break;
+        case OrderType::MODIFY: client.modify(m.instrument, o.order_id, o.price, o.quantity, tsc_now()); break;
+        default:                client.new_order(m.instrument, o.order_id, o, tsc_now()); break;
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc % 2 != 0) {
+        std::cerr << "usage: " << argv[0] << " <flow> [--unix path | --port P [--host H]] [--window W] [--warmup N] [--spin N]\n";
+        return 2;
+    }
+
+    Options options;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if      (std::strcmp(argv[i], "--unix") == 0)   options.unix_path = argv[i + 1];
+        else if (std::strcmp(argv[i], "--host") == 0)   options.host      = argv[i + 1];
+        else if (std::strcmp(argv[i], "--port") == 0)   options.port      = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--window") == 0) options.window    = std::max(1, std::atoi(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--warmup") == 0) options.warmup    = (size_t)std::atoll(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--spin") == 0)   options.spin      = (unsigned)std::atoi(argv[i + 1]);
+        else {
+            std::cerr << "loadgen: bad argument " << argv[i] << "\n";
+            return 2;
+        }
+    }
+
+    try {
+        // the flow's ids match a gateway that loaded the same file into a fresh engine
+        Engine                    engine;
+        std::vector<OrderMessage> messages = load_flow(argv[1], engine);
+
+        std::unique_ptr<Gateway> local;
+        if (options.unix_path.empty() && options.port < 0) {
+            GatewayOptions gateway_options;
+            gateway_options.unix_path  = "/tmp/loadgen." + std::to_string(getpid()) + ".sock";
+            gateway_options.spin_polls = options.spin;
+            local = std::make_unique<Gateway>(engine, gateway_options);
+            local->start();
+            options.unix_path = gateway_options.unix_path;
+        }
+
+        std::unique_ptr<GatewayClient> client =
+            options.unix_path.empty() ? std::make_unique<GatewayClient>(options.host, options.port)
+                                      : std::make_unique<GatewayClient>(options.unix_path);
+
+        const size_t total  = messages.size();
+        const size_t warmup = std::min(options.warmup, total);
+
+        Histogram rtt;
+        uint64_t  statuses[6] = {};
+        uint64_t  fills       = 0;
+        size_t    acked       = 0;
+
+        auto on_ack = [&](const AckMsg& ack) {
+            uint64_t ticks = tsc_now() - ack.sent_at;
+            if (acked++ >= warmup) rtt.record(ticks);
+            if ((size_t)ack.status < 6) ++statuses[(size_t)ack.status];
+        };
+        auto on_fill = [&](const FillMsg&) { ++fills; };
+
+        size_t   sent  = 0;
+        uint64_t start = 0;
+        while (acked < total) {
+            if (acked >= warmup && start == 0) start = now_ns();
+
+            size_t burst = 0;
+            while (sent < total && sent - acked < options.window) {
+                send(*client, messages[sent++]);
+                ++burst;
+            }
+            if (burst) client->flush();
+            client->receive(on_ack, on_fill);
+        }
+        uint64_t elapsed = now_ns() - (start ? start : now_ns());
+
+        if (local) local->stop();
+
+        HistogramSnapshot h    = rtt.snapshot();
+        double            rate = tsc_ticks_per_ns();
+        auto ns = [&](uint64_t ticks) { return (uint64_t)((double)ticks / rate + 0.5); };
+
+        std::cout << "  gateway     : " << (local ? "in-process, " : "") << (options.port >= 0 && !local
+                         ? options.host + ":" + std::to_string(options.port) : options.unix_path) << "\n";
+        std::cout << "  messages    : " << total << " (" << warmup << " warm-up), window " << options.window << "\n";
+        std::cout << "  acks        :";
+        for (size_t s = 0; s < 6; s++)
+            if (statuses[s]) std::cout << "  " << to_string((AckStatus)s) << "=" << statuses[s];
+        std::cout << "\n  fills       : " << fills << "\n";
+        std::cout << "  throughput  : " << std::fixed << std::setprecision(0)
+                  << (elapsed ? (double)(total - warmup) / ((double)elapsed / 1e9) : 0.0) << " msgs/sec\n\n";
+        std::cout << "  round trip       p50      p90      p99    p99.9   p99.99      max   (ns)\n";
+        std::cout << "  " << std::setw(10) << h.total
+                  << std::setw(10) << ns(h.percentile(50)) << std::setw(9) << ns(h.percentile(90))
+                  << std::setw(9) << ns(h.percentile(99)) << std::setw(9) << ns(h.percentile(99.9))
+                  << std::setw(9) << ns(h.percentile(99.99)) << std::setw(9) << ns(h.max) << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "loadgen: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
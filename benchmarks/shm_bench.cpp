@@ -0,0 +1,182 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../include/engine.hpp"
+#include "../include/metrics.hpp"
+#include "../include/shm_ring.hpp"
+
+// shmbench [--orders N] [--wait spin|futex] [--gap-ns G]
+//
+// Cross-process one-way latency through the shared-memory channel. The parent
+// hosts the Engine behind a ShmGateway; a forked producer process submits the
+// flow, one order every --gap-ns, and a forked reader process follows the
+// event ring. Inbound is producer claim -> matching-thread pop, timed by the
+// gateway; outbound is publish -> reader copy, timed by the reader. Both use
+// the TSC, which all cores share. The same flow is first timed through an
+// in-process Engine::submit for comparison. --wait defaults to spin when
+// there are cores for all three processes and futex otherwise; in futex mode
+// the producer sleeps out the gap instead of spinning it.
+
+namespace {
+
+const uint64_t SENTINEL = ~uint64_t(0);
+
+struct Options {
+    size_t   orders = 200000;
+    ShmWait  wait   = std::thread::hardware_concurrency() >= 3 ? ShmWait::SPIN : ShmWait::FUTEX;
+    uint64_t gap_ns = 1000;
+};
+
+std::vector<Order> make_flow(size_t n) {
+    std::vector<Order> flow;
+    flow.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        Order o{};
+        o.order_id  = i + 1;
+        o.side      = (i % 2 == 0) ? Side::BUY : Side::SELL;
+        o.type      = OrderType::LIMIT;
+        o.price     = to_fixed(o.side == Side::BUY ? 99.0 + (i % 3) : 100.0 + (i % 3));
+        o.quantity  = 100;
+        o.timestamp = i;
+        flow.push_back(o);
+    }
+    return flow;
+}
+
+void setup(Engine& engine) {
+    engine.add_symbol("AAPL", InstrumentConfig{to_fixed(0.01), to_fixed(50.0), to_fixed(150.0)});
+}
+
+void print_row(const char* label, const Histogram& h) {
+    HistogramSnapshot s    = h.snapshot();
+    double            rate = tsc_ticks_per_ns();
+    auto ns = [&](uint64_t ticks) { return (uint64_t)((double)ticks / rate + 0.5); };
+    std::cout << "  " << std::left << std::setw(34) << label << std::right
+              << std::setw(8) << ns(s.percentile(50)) << std::setw(9) << ns(s.percentile(90))
+              << std::setw(9) << ns(s.percentile(99)) << std::setw(9) << ns(s.percentile(99.9))
+              << std::setw(10) << ns(s.max) << "\n" << std::flush;
+}
+
+void spin_for(uint64_t ticks) {
+    uint64_t until = tsc_now() + ticks;
+    while (tsc_now() < until) cpu_relax();
+}
+
+void wait_byte(int fd) {
+    char byte;
+    if (read(fd, &byte, 1) != 1) _exit(1);
+}
+
+void send_byte(int fd) {
+    char byte = 1;
+    if (write(fd, &byte, 1) != 1) _exit(1);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if      (std::strcmp(argv[i], "--orders") == 0) options.orders = (size_t)std::atoll(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--gap-ns") == 0) options.gap_ns = (uint64_t)std::atoll(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--wait") == 0)
+            options.wait = std::strcmp(argv[i + 1], "spin") == 0 ? ShmWait::SPIN : ShmWait::FUTEX;
+        else {
+            std::cerr << "usage: " << argv[0] << " [--orders N] [--wait spin|futex] [--gap-ns G]\n";
+            return 2;
+        }
+    }
+
+    const std::vector<Order> flow = make_flow(options.orders);
+    const uint64_t           gap  = (uint64_t)((double)options.gap_ns * tsc_ticks_per_ns());
+
+    std::cout << "========================================\n";
+    std::cout << "  SHARED-MEMORY ORDER ENTRY (" << options.orders << " orders, one per "
+              << options.gap_ns << " ns, " << (options.wait == ShmWait::SPIN ? "spin" : "futex") << " wait)\n";
+    std::cout << "========================================\n";
+    std::cout << "  one-way latency (ns)                   p50      p90      p99    p99.9       max\n";
+
+    {
+        Engine    engine;
+        Histogram submit;
+        setup(engine);
+        auto on_trade = [](const Trade&) {};
+        for (const Order& o : flow) {
+            uint64_t t0 = tsc_now();
+            engine.submit(0, o, on_trade);
+            submit.record(tsc_now() - t0);
+            spin_for(gap);
+        }
+        print_row("in-process Engine::submit", submit);
+    }
+
+    Engine engine;
+    setup(engine);
+
+    const std::string name = "/orderbook_shmbench." + std::to_string(getpid());
+    ShmOptions shm;
+    shm.wait = options.wait;
+    ShmGateway gateway(engine, name, shm);
+    Histogram  inbound;
+    gateway.set_latency(&inbound);
+
+    // fork both children while this process is still single-threaded
+    int ready[2], go[2];
+    if (pipe(ready) != 0 || pipe(go) != 0) {
+        std::perror("pipe");
+        return 1;
+    }
+
+    pid_t reader = fork();
+    if (reader == 0) {
+        ShmClient client(name, options.wait, shm.spin_polls);
+        Histogram outbound;
+        bool      done = false;
+        send_byte(ready[1]);
+        while (!done) {
+            client.poll([&](const ShmEvent& e) {
+                outbound.record(tsc_now() - e.sent_tsc);
+                if (e.type == ShmEventType::REJECT && e.order_id == SENTINEL) done = true;
+            }, true);
+        }
+        print_row("shm outbound, engine -> reader", outbound);
+        if (client.lost()) std::cout << "  reader lost " << client.lost() << " events to overrun\n";
+        _exit(0);
+    }
+
+    pid_t producer = fork();
+    if (producer == 0) {
+        ShmClient client(name, options.wait, shm.spin_polls);
+        wait_byte(go[0]);
+        for (const Order& o : flow) {
+            client.submit(0, o);
+            // futex mode may share cores with the others: give them the gap
+            if (options.wait == ShmWait::SPIN) spin_for(gap);
+            else std::this_thread::sleep_for(std::chrono::nanoseconds(options.gap_ns));
+        }
+        Order sentinel{};
+        sentinel.order_id = SENTINEL;
+        client.submit(~InstrumentId(0), sentinel);  // unknown instrument: rejected, ends the reader
+        _exit(0);
+    }
+
+    wait_byte(ready[0]);
+    gateway.start();
+    send_byte(go[1]);
+
+    waitpid(producer, nullptr, 0);
+    gateway.stop();
+    waitpid(reader, nullptr, 0);
+
+    print_row("shm inbound, producer -> engine", inbound);
+    std::cout << "  processed " << gateway.processed() << " messages\n";
+    return 0;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "orderbook.hpp"
+#include "symbol_registry.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// One fill of a backtest, stamped with the message that printed it. The
+// merged stream is ordered by (file, record, fill): input order, which for a
+// journal or recorded flow is arrival and so timestamp order. No padding and
+// a zeroed reserved field, so the raw bytes are the same on every run.
+struct BacktestTrade {
+    uint64_t     timestamp;   // of the order that printed it, or of the last one before an uncross
+    uint64_t     record;      // record index within its file
+    uint32_t     file;        // index into the input list
+    uint32_t     fill;        // fill number within the message
+    InstrumentId instrument;  // backtest symbol id, in order of first registration
+    uint32_t     reserved;
+    Trade        trade;
+};
+
+static_assert(sizeof(BacktestTrade) == 72, "backtest trades must stay 72 bytes");
+
+// Non-owning reference to any callable taking `const BacktestTrade&`, as TradeSink.
+class BacktestSink {
+public:
+    template<typename F,
+             typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, BacktestSink>>>
+    BacktestSink(F&& f)
+        : ctx_((void*)std::addressof(f)),
+          fn_([](void* ctx, const BacktestTrade& trade) {
+              (*static_cast<std::remove_reference_t<F>*>(ctx))(trade);
+          }) {}
+
+    void operator()(const BacktestTrade& trade) const { fn_(ctx_, trade); }
+
+private:
+    void* ctx_;
+    void (*fn_)(void*, const BacktestTrade&);
+};
+
+struct BacktestReport {
+    size_t   files        = 0;
+    size_t   symbols      = 0;
+    size_t   messages     = 0;  // orders, mass cancels and auction calls applied
+    size_t   trades       = 0;
+    size_t   threads      = 0;
+    uint64_t steals       = 0;  // book tasks run by a worker they were not dealt to
+    uint64_t partition_ns = 0;
+    uint64_t match_ns     = 0;
+    uint64_t merge_ns     = 0;
+    uint64_t output_ns    = 0;  // handing the merged stream to on_trade
+};
+
+// Offline replay of journal-format files (journals or flows, e.g. one per
+// day) through fresh books, in parallel across symbols. Books never interact,
+// so:
+//   1. each file is mapped and split into per-symbol lists of record indices,
+//      one file per task;
+//   2. each symbol's records from every file, in file order, run through a
+//      private single-book Engine, one symbol per task, longest first, on a
+//      WorkStealingPool;
+//   3. each book scatters its trades straight to their place in the merged
+//      stream, found from per-file prefix sums of trades per record, and the
+//      stream goes to on_trade in order on the calling thread.
+// Symbols are matched across files by name; a book carries over from one file
+// to the next. The output depends only on the inputs, never on `threads`
+// (0 = one per hardware thread). Every trade is held in memory until the
+// merge, along with 8 bytes per input record. Throws std::runtime_error on a
+// bad file or a record for an instrument its file never registered.
+BacktestReport run_backtest(const std::vector<std::string>& paths, BacktestSink on_trade,
+                            size_t threads = 0);
@@ -0,0 +1,213 @@
+#pragma once
+
+#include "instrument.hpp"
+#include "order.hpp"
+#include "price_level.hpp"
+#include "tick_bitmap.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <vector>
+
+// One side of an OrderBook. Both containers below expose the same interface so
+// run_matching_loop and the rest of OrderBook are written once:
+//
+//   key_of(price) / price_of(key)  price <-> storage key
+//   within(level_key, limit_key)   level is at or better than an aggressor's limit
+//   empty() / best_key() / best_level() / pop_best()
+//   level_at(key)                  get-or-create, caller adds an order right after
+//   find(key) / erase(key)         erase only once the level is empty
+//   for_each_level(f)              f(key, level) for occupied levels, best first,
+//                                  until f returns false
+//   level_count()                  occupied levels, O(1)
+//   prefetch_best() / prefetch(key) cache hints ahead of matching / resting
+//   drain(lo, hi, f)               f(key, level) for occupied levels priced in
+//                                  [lo, hi], best first; levels f empties are dropped
+//   memory_bytes()                 heap held for levels
+
+// Tree-backed side. Works for any price, pays a tree walk per access.
+template<typename Compare>
+class PriceTree {
+public:
+    using key_type = Price;
+
+    key_type key_of(Price price) const { return price; }
+    Price    price_of(key_type key) const { return key; }
+
+    static bool within(key_type level, key_type limit) {
+        return !Compare{}(limit, level);
+    }
+
+    bool        empty()       const { return levels_.empty(); }
+    size_t      level_count() const { return levels_.size(); }
+    key_type    best_key()    const { return levels_.begin()->first; }
+    PriceLevel& best_level()       { return levels_.begin()->second; }
+    void        pop_best()         { levels_.erase(levels_.begin()); }
+
+    PriceLevel& level_at(key_type key) { return levels_[key]; }
+
+    PriceLevel* find(key_type key) {
+        auto it = levels_.find(key);
+        return it == levels_.end() ? nullptr : &it->second;
+    }
+
+    const PriceLevel* find(key_type key) const {
+        auto it = levels_.find(key);
+        return it == levels_.end() ? nullptr : &it->second;
+    }
+
+    void erase(key_type key) { levels_.erase(key); }
+
+    void prefetch_best() const {
+        if (levels_.empty()) return;
+        const PriceLevel& level = levels_.begin()->second;
+        __builtin_prefetch(&level);
+        __builtin_prefetch(level.head());
+    }
+
+    // finding the node is the tree walk itself, nothing to hint
+    void prefetch(key_type) const {}
+
+    template<typename F>
+    void for_each_level(F&& f) const {
+        for (const auto& [key, level] : levels_)
+            if (!f(key, level)) return;
+    }
+
+    template<typename F>
+    void drain(Price lo, Price hi, F&& f) {
+        // better end first: lo for asks, hi for bids
+        const Price first = Compare{}(lo, hi) ? lo : hi;
+        const Price last  = first == lo ? hi : lo;
+        for (auto it = levels_.lower_bound(first); it != levels_.end() && within(it->first, last);) {
+            f(it->first, it->second);
+            it = it->second.is_empty() ? levels_.erase(it) : std::next(it);
+        }
+    }
+
+    // one tree node per level: colour and three links ahead of the key and level
+    size_t memory_bytes() const {
+        return levels_.size() * (4 * sizeof(void*) + sizeof(std::pair<const Price, PriceLevel>));
+    }
+
+private:
+    std::map<Price, PriceLevel, Compare> levels_;
+};
+
+// Array-backed side. Prices are integer ticks relative to the instrument band,
+// every tick owns a slot, and best_ is a cursor onto the best non-empty slot.
+// No allocation or rebalancing after construction. A TickBitmap marks the
+// occupied slots, so when the best level empties the next one is found with a
+// few bit scans however wide the gap, and depth walks skip empty ticks.
+template<Side S>
+class PriceLadder {
+public:
+    using key_type = int64_t;
+
+    PriceLadder() = default;
+    explicit PriceLadder(const InstrumentConfig& config)
+        : config_(config), levels_(config.num_levels()), occupied_bits_(levels_.size()) {}
+
+    key_type key_of(Price price) const { return config_.to_ticks(price); }
+    Price    price_of(key_type key) const { return config_.to_price(key); }
+
+    // bids are better when higher, asks when lower
+    static bool within(key_type level, key_type limit) {
+        return (S == Side::BUY) ? (level >= limit) : (level <= limit);
+    }
+
+    bool        empty()       const { return occupied_ == 0; }
+    size_t      level_count() const { return occupied_; }
+    key_type    best_key()    const { return best_; }
+    PriceLevel& best_level()       { return levels_[best_]; }
+    void        pop_best()         { erase(best_); }
+
+    PriceLevel& level_at(key_type key) {
+        PriceLevel& level = levels_[key];
+        if (level.is_empty()) {
+            if (occupied_ == 0 || better(key, best_)) best_ = key;
+            occupied_bits_.set(key);
+            ++occupied_;
+        }
+        return level;
+    }
+
+    PriceLevel* find(key_type key) {
+        if (key < 0 || key >= (key_type)levels_.size()) return nullptr;
+        PriceLevel& level = levels_[key];
+        return level.is_empty() ? nullptr : &level;
+    }
+
+    const PriceLevel* find(key_type key) const {
+        if (key < 0 || key >= (key_type)levels_.size()) return nullptr;
+        const PriceLevel& level = levels_[key];
+        return level.is_empty() ? nullptr : &level;
+    }
+
+    void erase(key_type key) {
+        occupied_bits_.clear(key);
+        --occupied_;
+        if (occupied_ == 0 || key != best_) return;
+        best_ = next_from(key);
+    }
+
+    void prefetch_best() const {
+        if (occupied_ == 0) return;
+        __builtin_prefetch(&levels_[best_]);
+        __builtin_prefetch(levels_[best_].head());
+    }
+
+    void prefetch(key_type key) const {
+        if (key >= 0 && key < (key_type)levels_.size()) __builtin_prefetch(&levels_[key]);
+    }
+
+    template<typename F>
+    void for_each_level(F&& f) const {
+        if (occupied_ == 0) return;
+        for (key_type key = best_; key != TickBitmap::NONE; key = next_from(key + step())) {
+            if (!f(key, levels_[key])) return;
+        }
+    }
+
+    template<typename F>
+    void drain(Price lo, Price hi, F&& f) {
+        lo = std::max(lo, config_.min_price);
+        hi = std::min(hi, config_.max_price);
+        if (occupied_ == 0 || lo > hi) return;
+
+        const key_type low  = key_of(lo + config_.tick_size - 1);  // first tick at or above lo
+        const key_type high = key_of(hi);
+        key_type key = (S == Side::BUY) ? occupied_bits_.prev(high) : occupied_bits_.next(low);
+        while (key != TickBitmap::NONE && key >= low && key <= high) {
+            f(key, levels_[key]);
+            key_type next = next_from(key + step());
+            if (levels_[key].is_empty()) erase(key);
+            key = next;
+        }
+    }
+
+    // fixed at construction, whatever is resting
+    size_t memory_bytes() const {
+        return levels_.capacity() * sizeof(PriceLevel) + occupied_bits_.memory_bytes();
+    }
+
+private:
+    InstrumentConfig        config_;
+    std::vector<PriceLevel> levels_;
+    TickBitmap              occupied_bits_;
+    key_type                best_     = 0;
+    size_t                  occupied_ = 0;
+
+    // away from the touch: bids walk down, asks walk up
+    static constexpr key_type step() { return (S == Side::BUY) ? -1 : 1; }
+
+    // first occupied tick at or behind `key`, or TickBitmap::NONE
+    key_type next_from(key_type key) const {
+        return (S == Side::BUY) ? occupied_bits_.prev(key) : occupied_bits_.next(key);
+    }
+
+    static bool better(key_type a, key_type b) {
+        return (S == Side::BUY) ? (a > b) : (a < b);
+    }
+};
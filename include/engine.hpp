@@ -1,21 +1,147 @@
 #pragma once
 
+#include "order_pool.hpp"
 #include "orderbook.hpp"
+#include "risk.hpp"
+#include "symbol_registry.hpp"
+#include <memory>
 #include <string>
-#include <unordered_map>
+#include <vector>
+
+class JournalWriter;
+
+// One inbound message addressed to an instrument. Cancels and amends travel
+// as OrderType::CANCEL / OrderType::MODIFY orders. Used by submit_batch and the sharded engine.
+struct OrderMessage {
+    InstrumentId instrument;
+    Order        order;
+};
+
+// Where the fills of one batch message landed in BatchResult::trades.
+struct BatchFill {
+    uint32_t   begin;
+    uint32_t   count;
+    bool       rejected;  // failed pre-trade risk, or limit price outside a LADDER band / tick grid
+    RiskResult risk;      // why risk rejected it, ACCEPTED otherwise
+};
+
+// Output of submit_batch. Reuse one across calls: the buffers keep their
+// capacity, so a warmed-up gateway loop does not allocate.
+struct BatchResult {
+    std::vector<Trade>     trades;  // every fill of the batch, grouped by book
+    std::vector<BatchFill> fills;   // fills[i] -> messages[i]'s slice of trades
+    std::vector<uint64_t>  order;   // scratch: (instrument << 32 | index), sorted
+};
 
 class Engine {
 public:
+    // Registers a symbol with an explicit book layout. Symbols first seen through
+    // submit() get a default MAP-mode book. Returns false if the symbol already exists.
+    bool add_symbol(const std::string& symbol, const InstrumentConfig& config,
+                    BookMode mode = BookMode::LADDER);
+
+    // Resolve a symbol once and use the id from then on. intern() creates a
+    // MAP-mode book for an unseen symbol; find_symbol() never creates.
+    InstrumentId intern(const std::string& symbol);
+    std::optional<InstrumentId> find_symbol(const std::string& symbol) const;
+    const std::string& symbol_name(InstrumentId id) const { return symbols_.name(id); }
+    size_t instrument_count() const { return books_.size(); }
+
+    // Id-based API: a vector index, no hashing. `id` must come from this engine.
+    // submit returns the pre-trade risk verdict; a rejected order has no effect.
+    RiskResult submit(InstrumentId id, Order order, TradeSink on_trade);
+    std::vector<Trade> submit(InstrumentId id, Order order);
+    bool cancel(InstrumentId id, uint64_t order_id);
+    // false if the risk gate refuses the amend or the book does not hold the
+    // order. The amend is stamped with CLOCK_MONOTONIC for the rate window;
+    // submit a MODIFY order to carry a timestamp of your own.
+    bool modify(InstrumentId id, uint64_t order_id, Price price, uint64_t quantity,
+                TradeSink on_trade);
+
+    // Mass cancel on one book, or on every book: cancel-on-disconnect is
+    // mass_cancel(CancelFilter::owned_by(session)). Journaled as one record
+    // per book it touches.
+    MassCancelReport mass_cancel(InstrumentId id, const CancelFilter& filter);
+    MassCancelReport mass_cancel(const CancelFilter& filter);
+
+    // Call auction on one book, see OrderBook::begin_auction. Opening and
+    // uncrossing are journaled so a replay calls at the same points; uncross
+    // fills are reported to risk like any other.
+    void begin_auction(InstrumentId id, const AuctionOptions& options = {});
+    AuctionIndication uncross(InstrumentId id, TradeSink on_trade);
+    AuctionIndication indicative(InstrumentId id) const { return books_[id].indicative(); }
+
+    // Processes count messages as if submitted one by one in arrival order.
+    // Each is risk-checked and journaled right before it reaches its book.
+    // Books never interact, so messages are regrouped by book (stable within
+    // each book), each book is looked up once per group, and the next group's
+    // levels are prefetched while the current one matches.
+    void submit_batch(const OrderMessage* messages, size_t count, BatchResult& result);
+
+    std::optional<Price> best_bid(InstrumentId id) const;
+    std::optional<Price> best_ask(InstrumentId id) const;
+    std::optional<Price> spread(InstrumentId id)   const;
+
+    // market data: attach a listener per book, or read top-N depth on demand
+    void set_listener(InstrumentId id, BookListener* listener) { books_[id].set_listener(listener); }
+    std::vector<DepthLevel> depth(InstrumentId id, Side side, size_t n) const { return books_[id].depth(side, n); }
+
+    OrderBook&       book(InstrumentId id)       { return books_[id]; }
+    const OrderBook& book(InstrumentId id) const { return books_[id]; }
+
+    // String API: one registry lookup, then the id path.
+    RiskResult submit(const std::string& symbol, Order order, TradeSink on_trade);
     std::vector<Trade> submit(const std::string& symbol, Order order);
     bool cancel(const std::string& symbol, uint64_t order_id);
+    bool modify(const std::string& symbol, uint64_t order_id, Price price, uint64_t quantity,
+                TradeSink on_trade);
+
+    std::optional<Price> best_bid(const std::string& symbol) const;
+    std::optional<Price> best_ask(const std::string& symbol) const;
+    std::optional<Price> spread(const std::string& symbol)   const;
+
+    // resting-order nodes for every book, shared so capacity is sized once per engine
+    OrderPool& pool() { return *pool_; }
+
+    // Presizes book `id` for `orders` resting orders: its order-id table, and
+    // as many more nodes in the shared pool. Call before trading starts.
+    void reserve(InstrumentId id, size_t orders);
+
+    // Every book's usage summed; node_bytes is the whole pool, free nodes included.
+    MemoryUsage memory() const;
 
-    std::optional<double> best_bid(const std::string& symbol) const;
-    std::optional<double> best_ask(const std::string& symbol) const;
-    std::optional<double> spread(const std::string& symbol)   const;
+    // Write-ahead journal: every symbol registration and every inbound order,
+    // cancel or amend is appended before it reaches the book. One with a price
+    // the book refuses throws first and is never appended. Symbols that already
+    // exist are journaled on attach. Pass nullptr to detach.
+    void set_journal(JournalWriter* journal);
+    const JournalWriter* journal() const { return journal_; }
+
+    // Pre-trade risk: every order and amend is checked before it is journaled,
+    // and every fill and unfilled release is reported back, for every book,
+    // current and future. Pass nullptr to detach.
+    void set_risk(PreTradeRisk* risk);
+
+    // Live latency and book counters for every book, current and future.
+    // Read them with metrics->report() from any thread. nullptr detaches.
+    void set_metrics(EngineMetrics* metrics);
 
 private:
-    std::unordered_map<std::string, OrderBook> books_;
+    std::unique_ptr<OrderPool> pool_ = std::make_unique<OrderPool>();
+    size_t                     reserved_orders_ = 0;  // sum of reserve() calls, the pool's floor
+    SymbolRegistry             symbols_;
+    std::vector<OrderBook>     books_;  // indexed by InstrumentId
+    JournalWriter*             journal_ = nullptr;
+    PreTradeRisk*              risk_    = nullptr;
+    EngineMetrics*             metrics_ = nullptr;
+
+    void journal_symbol(InstrumentId id);
+
+    // intern(), timed as Stage::LOOKUP when metrics are attached
+    InstrumentId resolve(const std::string& symbol);
+
+    // risk check, write-ahead, match; shared by submit and submit_batch
+    RiskResult process(InstrumentId id, OrderBook& book, const Order& order, TradeSink& on_trade);
 
-    OrderBook* get_book(const std::string& symbol);
     const OrderBook* get_book_const(const std::string& symbol) const;
-};
\ No newline at end of file
+};
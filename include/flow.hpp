@@ -0,0 +1,42 @@
+#pragma once
+
+#include "engine.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Shape of a synthetic order flow. Ratios are shares of all messages; what is
+// left after cancels, replaces and market orders is new limit orders.
+struct FlowProfile {
+    uint64_t seed    = 1;
+    size_t   orders  = 1000000;   // messages, symbol records not counted
+    size_t   symbols = 100;
+
+    double zipf_s        = 1.1;   // symbol popularity, rank k drawn with weight 1 / k^s
+    double cancel_ratio  = 0.35;  // cancel a random live order of the symbol
+    double replace_ratio = 0.25;  // MODIFY a live order: new quantity, sometimes a new price
+    double market_ratio  = 0.02;
+    double cross_ratio   = 0.10;  // share of limit orders priced through the touch
+
+    // passive limits land k ticks behind the mid with weight (1 - depth_decay)^k,
+    // k < depth_levels, so the book is thick near the touch and thins out behind
+    uint32_t depth_levels = 50;
+    double   depth_decay  = 0.08;
+
+    double   drift      = 0.02;   // chance per message that the symbol's mid moves one tick
+    double   tick_size  = 0.01;
+    double   base_price = 100.0;  // every symbol starts here, inside a +-50% LADDER band
+    uint32_t lot        = 100;    // quantities are 1..10 lots
+};
+
+// Writes `profile` as a journal-format flow file: SYMBOL records first, then
+// one ORDER record per message. Output depends only on the profile, not on
+// the platform or standard library. Returns the number of order messages.
+size_t generate_flow(const FlowProfile& profile, const std::string& path);
+
+// Reads a journal-format flow, recorded or generated. Its symbols are
+// registered on `engine` (LADDER ones with their config, the rest as MAP
+// books) and its orders are returned addressed by `engine`'s instrument ids.
+// Throws std::runtime_error on a bad file or an unknown record type.
+std::vector<OrderMessage> load_flow(const std::string& path, Engine& engine);
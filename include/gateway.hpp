@@ -0,0 +1,281 @@
+#pragma once
+
+#include "engine.hpp"
+#include "spsc_queue.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Wire protocol: fixed-size frames in host byte order, each starting with a
+// MsgHeader whose length covers the whole frame. Every field is naturally
+// aligned, so a frame is decoded with one memcpy straight out of the receive
+// buffer. A client picks its own order ids (below 2^40) and gets exactly one
+// ACK per request, after any FILLs the request caused.
+enum class MsgType : uint8_t {
+    NEW_ORDER = 1,
+    CANCEL    = 2,
+    MODIFY    = 3,
+    ACK       = 16,
+    FILL      = 17
+};
+
+enum class AckStatus : uint8_t {
+    ACCEPTED,
+    RISK_REJECTED,       // see AckMsg::risk
+    BAD_PRICE,           // off the LADDER band or tick grid
+    UNKNOWN_ORDER,       // cancel/modify of an id that is not resting, or an amend refused
+    UNKNOWN_INSTRUMENT,
+    BAD_ORDER_ID         // client order id does not fit in 40 bits
+};
+
+const char* to_string(AckStatus status);
+
+struct MsgHeader {
+    uint16_t length;
+    MsgType  type;
+    uint8_t  reserved;
+};
+
+struct NewOrderMsg {
+    MsgHeader header;
+    uint32_t  instrument;
+    uint64_t  client_order_id;
+    int64_t   price;              // fixed point, see Price
+    uint64_t  quantity;
+    uint64_t  display_quantity;   // or a stop's trigger price
+    uint64_t  sent_at;            // client clock, echoed in the ACK
+    uint32_t  account;
+    uint8_t   side;
+    uint8_t   type;               // LIMIT, MARKET, STOP or STOP_LIMIT
+    uint8_t   tif;
+    uint8_t   post_only;
+};
+
+struct CancelMsg {
+    MsgHeader header;
+    uint32_t  instrument;
+    uint64_t  client_order_id;
+    uint64_t  sent_at;
+};
+
+struct ModifyMsg {
+    MsgHeader header;
+    uint32_t  instrument;
+    uint64_t  client_order_id;
+    int64_t   price;
+    uint64_t  quantity;
+    uint64_t  sent_at;
+};
+
+struct AckMsg {
+    MsgHeader header;
+    uint32_t  instrument;
+    uint64_t  client_order_id;
+    uint64_t  sent_at;
+    MsgType   request;
+    AckStatus status;
+    uint8_t   risk;               // RiskResult when status is RISK_REJECTED
+    uint8_t   reserved[5];
+};
+
+struct FillMsg {
+    MsgHeader header;
+    uint32_t  instrument;
+    uint64_t  client_order_id;
+    int64_t   price;
+    uint64_t  quantity;
+    uint8_t   side;               // side of the client's order
+    uint8_t   reserved[7];
+};
+
+static_assert(sizeof(NewOrderMsg) == 56 && sizeof(CancelMsg) == 24 && sizeof(ModifyMsg) == 40,
+              "request frames must not carry padding");
+static_assert(sizeof(AckMsg) == 32 && sizeof(FillMsg) == 40, "report frames must not carry padding");
+
+constexpr size_t MAX_FRAME = sizeof(NewOrderMsg);
+
+struct GatewayOptions {
+    int         tcp_port  = -1;          // -1 = no TCP listener, 0 = any free port
+    std::string unix_path;               // empty = no Unix-domain listener
+    size_t      queue_capacity = 1 << 16;
+    size_t      max_backlog    = 16 << 20; // unsent report bytes before a slow client is dropped
+    int         io_core    = -1;         // < 0 leaves the thread unpinned
+    int         match_core = -1;
+    unsigned    spin_polls = 1000;       // idle polls before a thread parks on its doorbell
+    bool        cancel_on_disconnect = false;  // pull a session's resting orders when it drops
+};
+
+// Socket front end for one Engine. An I/O thread runs a level-triggered epoll
+// loop over the listeners and every connection, decodes complete frames in
+// place and pushes them into an SPSC ring. A matching thread owns the Engine,
+// drains the ring and pushes encoded ACK/FILL frames into a second ring that
+// the I/O thread copies into per-connection send buffers. Either thread spins
+// for spin_polls empty polls, then parks; the other side rings an eventfd
+// doorbell only when it sees the flag, so a busy gateway makes no wake-up calls.
+//
+// Each connection is a session with a gateway-assigned id; the engine order id
+// is (session << 40 | client order id), so a fill names its owner without a
+// lookup table and two clients may reuse the same ids. Orders of a closed
+// session stay in the book unless cancel_on_disconnect is set; then the
+// matching thread mass-cancels the session's owner tag across every book.
+//
+// Threading contract: register symbols on the Engine before start(), and do
+// not touch the Engine again until stop() returns.
+class Gateway {
+public:
+    Gateway(Engine& engine, GatewayOptions options);
+    ~Gateway();
+
+    Gateway(const Gateway&)            = delete;
+    Gateway& operator=(const Gateway&) = delete;
+
+    // binds the listeners (throws std::runtime_error) and starts both threads
+    void start();
+    // stops reading, lets the matching thread finish what was read, sends the
+    // last reports, then closes every connection
+    void stop();
+
+    int tcp_port() const { return tcp_port_; }  // bound port, useful with tcp_port = 0
+
+    // the session is the engine order id's owner tag, see owner_of()
+    static constexpr int      SESSION_SHIFT  = OWNER_SHIFT;
+    static constexpr uint64_t CLIENT_ID_MASK = OWNER_ID_MASK;
+
+private:
+    struct Request {
+        uint32_t     session;
+        InstrumentId instrument;
+        uint64_t     client_order_id;
+        uint64_t     sent_at;
+        Order        order;
+        bool         disconnect = false;  // the session closed: mass-cancel its orders
+    };
+
+    struct Report {
+        uint32_t session;
+        uint16_t length;
+        alignas(8) unsigned char frame[sizeof(FillMsg)];
+    };
+
+    struct Connection {
+        int                        fd;
+        uint32_t                   session;
+        std::vector<unsigned char> rx;
+        size_t                     rx_len = 0;
+        std::vector<unsigned char> tx;
+        size_t                     tx_sent = 0;
+        bool                       dirty   = false;  // listed in dirty_
+        bool                       writing = false;  // EPOLLOUT registered
+    };
+
+    Engine&        engine_;
+    GatewayOptions options_;
+    size_t         instruments_ = 0;
+
+    SpscQueue<Request> inbound_;
+    SpscQueue<Report>  outbound_;
+
+    int epoll_fd_   = -1;
+    int io_bell_    = -1;   // eventfds, rung only for a parked thread
+    int match_bell_ = -1;
+    int tcp_fd_   = -1;
+    int unix_fd_  = -1;
+    int tcp_port_ = -1;
+
+    // I/O thread only
+    std::unordered_map<uint32_t, std::unique_ptr<Connection>> sessions_;
+    std::vector<Connection*> dirty_;   // have unsent bytes after the last drain
+    uint32_t next_session_ = 1;        // 0 marks orders entered outside the gateway; wraps below OWNER_LIMIT
+    uint64_t in_flight_    = 0;        // requests pushed whose ACK has not been drained
+
+    std::thread       io_thread_;
+    std::thread       match_thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> reading_done_{false};   // I/O thread pushes no more requests
+    std::atomic<bool> matching_done_{false};
+    std::atomic<bool> io_parked_{false};
+    std::atomic<bool> match_parked_{false};
+
+    void run_io();
+    void run_matching();
+
+    void accept_all(int listener);
+    bool read_from(Connection& conn);   // false: peer closed or sent a bad frame
+    bool decode(Connection& conn, const unsigned char* frame, MsgType type, uint16_t length);
+    void enqueue(const Request& request);
+    size_t drain_reports();
+    void flush_dirty();
+    bool flush(Connection& conn);
+    void close_session(uint32_t session);
+
+    void process(const Request& request);
+    void report(uint32_t session, const void* frame, uint16_t length);
+};
+
+// Blocking client for tests and the load generator. Requests are buffered
+// until flush(); receive() hands back whole ACK and FILL frames.
+class GatewayClient {
+public:
+    explicit GatewayClient(const std::string& unix_path);
+    GatewayClient(const std::string& host, int port);
+    ~GatewayClient();
+
+    GatewayClient(const GatewayClient&)            = delete;
+    GatewayClient& operator=(const GatewayClient&) = delete;
+
+    void new_order(InstrumentId instrument, uint64_t client_order_id, const Order& order, uint64_t sent_at);
+    void cancel(InstrumentId instrument, uint64_t client_order_id, uint64_t sent_at);
+    void modify(InstrumentId instrument, uint64_t client_order_id, Price price, uint64_t quantity,
+                uint64_t sent_at);
+    void flush();
+
+    // Reads what has arrived, waiting for at least one frame when `wait`, and
+    // calls on_ack(const AckMsg&) / on_fill(const FillMsg&) for each. Returns
+    // the number of frames handled; throws once the gateway has closed.
+    template<typename OnAck, typename OnFill>
+    size_t receive(OnAck&& on_ack, OnFill&& on_fill, bool wait = true) {
+        size_t handled = 0;
+        do {
+            if (!read_some(wait)) return handled;
+
+            size_t offset = 0;
+            while (rx_len_ - offset >= sizeof(MsgHeader)) {
+                MsgHeader header;
+                std::memcpy(&header, &rx_[offset], sizeof(header));
+                if (header.length < sizeof(MsgHeader)) throw std::runtime_error("gateway sent a malformed frame");
+                if (rx_len_ - offset < header.length) break;
+
+                if (header.type == MsgType::ACK) {
+                    AckMsg ack;
+                    std::memcpy(&ack, &rx_[offset], sizeof(ack));
+                    on_ack(ack);
+                } else if (header.type == MsgType::FILL) {
+                    FillMsg fill;
+                    std::memcpy(&fill, &rx_[offset], sizeof(fill));
+                    on_fill(fill);
+                }
+                offset += header.length;
+                ++handled;
+            }
+            std::memmove(rx_.data(), rx_.data() + offset, rx_len_ - offset);
+            rx_len_ -= offset;
+        } while (wait && handled == 0);
+        return handled;
+    }
+
+private:
+    int                        fd_ = -1;
+    std::vector<unsigned char> tx_;
+    std::vector<unsigned char> rx_;
+    size_t                     rx_len_ = 0;
+
+    void append(const void* frame, size_t length);
+    bool read_some(bool wait);
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "order.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// How an OrderBook stores its price levels.
+//   MAP    -> std::map keyed on fixed-point price (any price, tree walk per access)
+//   LADDER -> flat array of levels indexed by integer tick inside a price band
+enum class BookMode {
+    MAP,
+    LADDER
+};
+
+// Static per-symbol parameters, all fixed point (see to_fixed). The band
+// [min_price, max_price] is inclusive and sized to where the flow actually
+// lands — every tick in it costs one PriceLevel.
+struct InstrumentConfig {
+    Price tick_size = to_fixed(0.01);
+    Price min_price = 0;
+    Price max_price = 0;
+
+    // band-relative tick index, 0 == min_price
+    int64_t to_ticks(Price price) const {
+        return (price - min_price) / tick_size;
+    }
+
+    Price to_price(int64_t ticks) const {
+        return min_price + ticks * tick_size;
+    }
+
+    size_t num_levels() const {
+        return (size_t)to_ticks(max_price) + 1;
+    }
+
+    // true if price lies inside the band and on a tick boundary
+    bool is_valid_price(Price price) const {
+        if (price < min_price || price > max_price) return false;
+        return (price - min_price) % tick_size == 0;
+    }
+};
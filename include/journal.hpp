@@ -0,0 +1,169 @@
+#pragma once
+
+#include "instrument.hpp"
+#include "order.hpp"
+#include "orderbook.hpp"
+#include "symbol_registry.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Engine;
+
+// On-disk layout: one 64-byte JournalHeader followed by 64-byte records, host
+// byte order. Nothing is variable length, so a reader can index straight into
+// an mmap of the file.
+enum class JournalRecordType : uint32_t {
+    SYMBOL = 1,  // instrument registration, precedes its first order
+    ORDER  = 2,  // inbound Order (LIMIT, MARKET, CANCEL or MODIFY) as received
+    MASS_CANCEL = 3, // Engine::mass_cancel on one book, with its CancelFilter
+    AUCTION = 4      // Engine::begin_auction or Engine::uncross on one book
+};
+
+enum class JournalAuction : uint8_t {
+    BEGIN   = 1,
+    UNCROSS = 2
+};
+
+struct JournalHeader {
+    char     magic[8];      // "OBJRNL\0\1"
+    uint32_t version;
+    uint32_t record_size;
+    uint8_t  reserved[48];
+};
+
+struct JournalRecord {
+    JournalRecordType type;
+    InstrumentId      instrument;
+    uint64_t          sequence;
+
+    union {
+        struct {
+            uint64_t order_id;
+            uint64_t timestamp;
+            int64_t  price;      // fixed point, see Price
+            uint64_t quantity;
+            uint64_t display_quantity;  // or a stop's trigger price
+            uint32_t account;
+            uint8_t  side;
+            uint8_t  type;
+            uint8_t  tif;
+            uint8_t  post_only;
+        } order;
+
+        struct {
+            int64_t  min_price;
+            int64_t  max_price;
+            uint32_t owner;
+            uint8_t  bids;
+            uint8_t  asks;
+            uint8_t  by_owner;
+            uint8_t  reserved;
+        } cancel;
+
+        struct {
+            int64_t  reference;      // AuctionOptions::reference when has_reference
+            uint32_t indicate_every;
+            uint8_t  action;         // JournalAuction
+            uint8_t  has_reference;
+            uint8_t  reserved[2];
+        } auction;
+
+        struct {
+            char     name[20];   // NUL-padded, longer symbols are rejected
+            uint32_t mode;
+            int64_t  tick_size;  // fixed point, as InstrumentConfig
+            int64_t  min_price;
+            int64_t  max_price;
+        } symbol;
+    };
+};
+
+static_assert(sizeof(JournalHeader) == 64, "journal header must stay 64 bytes");
+static_assert(sizeof(JournalRecord) == 64, "journal records must stay 64 bytes");
+
+// When appended records are pushed to the kernel and made durable.
+//   NONE  -> write() per batch, never fsync (page cache only)
+//   BATCH -> write() + fsync once per batch (group commit)
+//   EVERY -> write() + fsync after every record
+enum class SyncPolicy {
+    NONE,
+    BATCH,
+    EVERY
+};
+
+struct JournalOptions {
+    SyncPolicy sync          = SyncPolicy::BATCH;
+    size_t     batch_records = 256;  // records buffered per write()/fsync
+};
+
+// Append-only writer. Records are buffered in memory and written as one batch;
+// with SyncPolicy::BATCH a crash can lose at most the unflushed batch.
+// Throws std::runtime_error if the file cannot be opened or written.
+class JournalWriter {
+public:
+    JournalWriter(const std::string& path, JournalOptions options = {});
+    ~JournalWriter();
+
+    JournalWriter(const JournalWriter&)            = delete;
+    JournalWriter& operator=(const JournalWriter&) = delete;
+
+    void append_symbol(InstrumentId id, const std::string& symbol,
+                       const InstrumentConfig& config, BookMode mode);
+    void append_order(InstrumentId id, const Order& order);
+    void append_mass_cancel(InstrumentId id, const CancelFilter& filter);
+    void append_auction(InstrumentId id, JournalAuction action, const AuctionOptions& options);
+
+    // writes whatever is buffered and fsyncs unless the policy is NONE
+    void flush();
+
+    uint64_t records() const { return sequence_; }
+
+private:
+    int                        fd_ = -1;
+    JournalOptions             options_;
+    std::vector<JournalRecord> buffer_;
+    uint64_t                   sequence_ = 0;
+
+    void append(const JournalRecord& record);
+    void write_all(const void* data, size_t size);
+};
+
+// Read-only view of a journal through mmap, advised for sequential access.
+// Throws std::runtime_error on a missing file or a bad header.
+class JournalReader {
+public:
+    explicit JournalReader(const std::string& path);
+    ~JournalReader();
+
+    JournalReader(const JournalReader&)            = delete;
+    JournalReader& operator=(const JournalReader&) = delete;
+
+    const JournalRecord* begin() const { return records_; }
+    const JournalRecord* end()   const { return records_ + count_; }
+    size_t               size()  const { return count_; }
+
+private:
+    void*                mapping_ = nullptr;
+    size_t               length_  = 0;
+    const JournalRecord* records_ = nullptr;
+    size_t               count_   = 0;
+};
+
+Order journal_order(const JournalRecord& record);
+
+// Rebuilds engine state by re-submitting every journaled message in order.
+// Matching is deterministic, so the fills handed to on_trade are the same,
+// in the same order, as in the run that wrote the journal. `engine` should be
+// fresh, or restored from a snapshot taken at journal sequence `from_sequence`,
+// in which case only orders from that sequence on are re-submitted. Journal
+// instrument ids are remapped to whatever ids the engine assigns.
+// Returns the number of orders, mass cancels and auction calls replayed.
+size_t replay(const JournalReader& journal, Engine& engine, TradeSink on_trade,
+              uint64_t from_sequence = 0);
+
+// Applies one ORDER, MASS_CANCEL or AUCTION record to book `id` exactly as
+// replay() does, for callers that route records themselves. Throws
+// std::runtime_error on any other record type; replay() does the same.
+void apply_record(const JournalRecord& record, Engine& engine, InstrumentId id, TradeSink on_trade);
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "order.hpp"
+#include "spsc_queue.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Aggregate state of one price level after a change. quantity == 0 means the
+// level is gone.
+struct LevelUpdate {
+    Price    price;
+    uint64_t quantity;
+    Side     side;
+};
+
+// One row of a top-N depth snapshot.
+struct DepthLevel {
+    Price    price;
+    uint64_t quantity;
+};
+
+// L3 (order-by-order) event kinds.
+enum class OrderEventType : uint8_t {
+    ADD,      // order rested at the back of its level
+    MODIFY,   // resting order amended in place
+    EXECUTE,  // resting order (partially) filled at the front of its level
+    DELETE    // resting order removed by cancel
+};
+
+// Fixed 40-byte wire/queue record. `quantity` is what rests after the event
+// (0 once gone), `delta` what the event added, executed or removed,
+// `position` the 0-based place in the level's FIFO before it.
+struct OrderEvent {
+    uint64_t       order_id;
+    Price          price;
+    uint64_t       quantity;
+    uint64_t       delta;
+    uint32_t       position;
+    OrderEventType type;
+    uint8_t        side;      // Side as uint8_t to keep the record packed
+    uint8_t        reserved[2];
+};
+
+static_assert(sizeof(OrderEvent) == 40, "OrderEvent must stay 40 bytes");
+
+// Where a call auction would uncross right now. volume == 0 means the book
+// does not cross and price means nothing.
+struct AuctionIndication {
+    Price    price;
+    uint64_t volume;     // quantity that executes at price
+    int64_t  imbalance;  // buy quantity left unmatched at price minus sell quantity
+};
+
+// Receives book changes synchronously on the matching thread. Overrides must
+// be cheap; anything slow belongs behind a conflating or queueing listener.
+class BookListener {
+public:
+    virtual ~BookListener() = default;
+
+    // a level's total quantity changed (fill, new resting order, cancel)
+    virtual void on_level(const LevelUpdate&) {}
+
+    // a single resting order was added, modified, executed or deleted
+    virtual void on_order(const OrderEvent&) {}
+
+    // the indicative uncross moved during a call auction
+    virtual void on_auction(const AuctionIndication&) {}
+};
+
+// L3 listener that copies each OrderEvent into an SPSC ring for a publisher
+// thread to drain, so encoding and I/O stay off the matching thread. Events
+// that find the ring full are counted and dropped rather than stalling matching.
+class OrderEventQueue : public BookListener {
+public:
+    explicit OrderEventQueue(size_t capacity = 1 << 16) : queue_(capacity) {}
+
+    void on_order(const OrderEvent& event) override {
+        if (!queue_.try_push(event)) dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // consumer side
+    bool try_pop(OrderEvent& event) { return queue_.try_pop(event); }
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    SpscQueue<OrderEvent> queue_;
+    std::atomic<uint64_t> dropped_{0};
+};
+
+// Merges bursts of level updates so each touched level is published at most
+// once per interval, carrying only its latest quantity. Levels are emitted in
+// the order they were first touched during the interval.
+class ConflatingPublisher : public BookListener {
+public:
+    explicit ConflatingPublisher(uint64_t interval_ns = 0) : interval_ns_(interval_ns) {}
+
+    void on_level(const LevelUpdate& update) override;
+
+    // hands every pending update to emit and clears them; returns how many
+    template<typename F>
+    size_t flush(F&& emit) {
+        for (const LevelUpdate& update : pending_) emit(update);
+        size_t count = pending_.size();
+        pending_.clear();
+        index_[0].clear();
+        index_[1].clear();
+        return count;
+    }
+
+    // flush() once the interval since the last publish has elapsed
+    template<typename F>
+    size_t publish(uint64_t now_ns, F&& emit) {
+        if (now_ns < next_publish_ns_) return 0;
+        next_publish_ns_ = now_ns + interval_ns_;
+        return flush(emit);
+    }
+
+    size_t pending() const { return pending_.size(); }
+
+private:
+    uint64_t                 interval_ns_;
+    uint64_t                 next_publish_ns_ = 0;
+    std::vector<LevelUpdate> pending_;
+    std::unordered_map<Price, size_t> index_[2];  // per side: price -> slot in pending_
+};
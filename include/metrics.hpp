@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// Cycle counter for stage timing: one rdtsc, no syscall, no serialisation.
+// Other architectures fall back to steady_clock nanoseconds.
+inline uint64_t tsc_now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// tsc_now() ticks per nanosecond, measured once against steady_clock on first use
+double tsc_ticks_per_ns();
+
+// Plain copy of a Histogram taken at one moment; owns its counts.
+struct HistogramSnapshot {
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t max   = 0;
+    uint64_t sum   = 0;
+
+    // highest value equivalent to the bucket holding the p-th percentile (0..100)
+    uint64_t percentile(double p) const;
+    double   mean() const { return total ? (double)sum / total : 0.0; }
+};
+
+// HDR-style log-linear histogram: exact below 128, then 64 linear sub-buckets
+// per power of two, so any recorded value is reported within 1/64 (~1.6%).
+// Fixed storage, O(1) record, no allocation. One thread records; any thread
+// may snapshot() concurrently, since counts are relaxed atomics written with
+// plain load+store (no locked instruction on the hot path).
+class Histogram {
+public:
+    static constexpr int    SUB_BITS     = 6;
+    static constexpr size_t SUB_BUCKETS  = size_t(1) << SUB_BITS;        // 64 per octave
+    static constexpr size_t LINEAR_LIMIT = size_t(2) << SUB_BITS;        // exact below 128
+    static constexpr size_t BUCKETS      = LINEAR_LIMIT + (64 - SUB_BITS - 1) * SUB_BUCKETS;
+
+    void record(uint64_t value) {
+        bump(counts_[index_of(value)]);
+        bump(total_);
+        sum_.store(sum_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        if (value > max_.load(std::memory_order_relaxed)) max_.store(value, std::memory_order_relaxed);
+    }
+
+    HistogramSnapshot snapshot() const;
+
+    static size_t index_of(uint64_t value) {
+        if (value < LINEAR_LIMIT) return (size_t)value;
+        int shift = 63 - __builtin_clzll(value) - SUB_BITS;  // >= 1 here
+        return LINEAR_LIMIT + (size_t)(shift - 1) * SUB_BUCKETS + (size_t)((value >> shift) - SUB_BUCKETS);
+    }
+
+    // largest value that lands in bucket `index`
+    static uint64_t highest_in(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> counts_{};
+    std::atomic<uint64_t> total_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+
+    static void bump(std::atomic<uint64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+};
+
+// Where time goes inside the engine, each timed with tsc_now():
+//   LOOKUP -> symbol string to InstrumentId (string API only)
+//   SUBMIT -> Engine::submit end to end: risk, journal, match, rest
+//   MATCH  -> run_matching_loop for one order
+//   REST   -> queueing a remainder at its level (timed with the order's MATCH)
+//   CANCEL -> cancel by order_id
+enum class Stage : uint8_t {
+    LOOKUP,
+    SUBMIT,
+    MATCH,
+    REST,
+    CANCEL,
+    COUNT
+};
+
+const char* to_string(Stage stage);
+
+struct MetricsReport;
+
+// Live instrumentation for one Engine (one matching thread). Attach with
+// Engine::set_metrics; report() may be called from any thread while
+// matching continues. Counters see every order; stage timings see one in
+// 2^sample_shift per stage, since each timed stage costs two tsc reads.
+struct EngineMetrics {
+    std::array<Histogram, (size_t)Stage::COUNT> stages;  // TSC ticks
+    Histogram fills_per_order;   // per matching pass (new order or crossing amend)
+    Histogram levels_touched;    // distinct price levels one matching pass traded at
+    Histogram book_depth;        // occupied levels, both sides, after each order
+
+    // calibrates the TSC up front so the first report() does not stall
+    explicit EngineMetrics(unsigned sample_shift = 0);
+
+    // matching thread only: should this occurrence of `stage` be timed?
+    bool sample(Stage stage) { return (seen_[(size_t)stage]++ & sample_mask_) == 0; }
+
+    void record(Stage stage, uint64_t ticks) { stages[(size_t)stage].record(ticks); }
+
+    MetricsReport report() const;
+
+private:
+    uint64_t                                   sample_mask_;
+    std::array<uint64_t, (size_t)Stage::COUNT> seen_{};
+};
+
+struct MetricsReport {
+    std::array<HistogramSnapshot, (size_t)Stage::COUNT> stages;
+    HistogramSnapshot fills_per_order;
+    HistogramSnapshot levels_touched;
+    HistogramSnapshot book_depth;
+    double            ticks_per_ns;
+
+    // stage percentiles in ns and the counter distributions, one line each
+    void print(std::ostream& out) const;
+};
@@ -1,22 +1,83 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 
-enum class Side {
+// Prices are fixed point: a signed count of 1/PRICE_SCALE units, 8 decimal
+// places. They compare exactly, key maps without epsilon games and map onto
+// ladder ticks with one integer division. Doubles only appear at the edges.
+using Price = int64_t;
+
+constexpr Price PRICE_SCALE = 100'000'000;
+
+constexpr Price to_fixed(double value) {
+    return (Price)(value * (double)PRICE_SCALE + (value < 0 ? -0.5 : 0.5));
+}
+
+constexpr double to_double(Price price) {
+    return (double)price / (double)PRICE_SCALE;
+}
+
+enum class Side : uint8_t {
     BUY,
     SELL
 };
 
-enum class OrderType {
+enum class OrderType : uint8_t {
     LIMIT,
     MARKET,
-    CANCEL
+    CANCEL,
+    MODIFY,     // amend resting order_id to price/quantity; side comes from the book
+    STOP,       // MARKET once a trade prints at or through stop_price
+    STOP_LIMIT  // LIMIT at price once a trade prints at or through stop_price
 };
 
+constexpr bool is_stop(OrderType type) {
+    return type == OrderType::STOP || type == OrderType::STOP_LIMIT;
+}
+
+// How long an order may trade.
+//   GTC -> match, then rest whatever is left
+//   IOC -> match what is available now, drop the rest
+//   FOK -> match the whole quantity now or nothing at all
+enum class TimeInForce : uint8_t {
+    GTC,
+    IOC,
+    FOK
+};
+
+// Wire and in-book form of an order. Fields the matching loop reads sit in
+// the first 32 bytes; the four one-byte attributes share a word with account.
+// A stop waits on its trigger in the slot an iceberg uses for its peak, so a
+// stop cannot also be an iceberg; it is elected with display_quantity 0.
 struct Order {
-    uint64_t order_id;
-    uint64_t timestamp;
-    double price;
-    uint64_t quantity;
-    Side side;
-    OrderType type;
-};
\ No newline at end of file
+    uint64_t    order_id;
+    Price       price;
+    uint64_t    quantity;
+    uint32_t    account = 0;                // owning account, dense id used by pre-trade risk
+    Side        side;
+    OrderType   type;
+    TimeInForce tif       = TimeInForce::GTC;
+    bool        post_only = false;          // never takes liquidity; dropped if it would cross
+    union {
+        uint64_t display_quantity = 0;      // iceberg peak shown in the book, 0 = show everything
+        Price    stop_price;                // STOP / STOP_LIMIT trigger
+    };
+    uint64_t    timestamp;
+};
+
+static_assert(sizeof(Order) == 48, "Order must stay 48 bytes");
+static_assert(offsetof(Order, account) == 24 && offsetof(Order, side) == 28,
+              "matching-loop fields must stay in the first 32 bytes");
+
+// Owner tag: the top 24 bits of order_id say who entered the order (the
+// gateway puts its session there) and the low 40 are the owner's own id, so
+// orders can be selected by owner without a field. Plain ids below 2^40
+// belong to owner 0. Owners are therefore limited to [0, OWNER_LIMIT), 2^24
+// of them; a larger owner value never matches an order.
+constexpr int      OWNER_SHIFT   = 40;
+constexpr uint64_t OWNER_ID_MASK = (uint64_t(1) << OWNER_SHIFT) - 1;
+constexpr uint32_t OWNER_LIMIT   = uint32_t(1) << (64 - OWNER_SHIFT);
+
+constexpr uint32_t owner_of(uint64_t order_id) {
+    return (uint32_t)(order_id >> OWNER_SHIFT);
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "order_pool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Flat order_id -> OrderNode* table. Open addressing with linear probing over
+// a power-of-two array of 16-byte slots, so a lookup is one multiply and
+// usually one cache line, and an entry costs no allocation. A null node marks
+// an empty slot; any 64-bit id is a valid key.
+//
+// Erase shifts the rest of the probe run back into the hole instead of
+// leaving a tombstone, so probe lengths depend only on the live entries and
+// do not creep up over a session of adds and fills. The table doubles past
+// 3/4 load and never shrinks: its size tracks the peak resting count, and
+// reserve() fixes it up front.
+class OrderIndex {
+public:
+    OrderIndex() = default;
+    explicit OrderIndex(size_t orders) { reserve(orders); }
+
+    OrderNode* find(uint64_t order_id) const {
+        if (size_ == 0) return nullptr;
+        for (size_t i = bucket(order_id);; i = (i + 1) & mask_) {
+            const Slot& slot = slots_[i];
+            if (!slot.node) return nullptr;
+            if (slot.order_id == order_id) return slot.node;
+        }
+    }
+
+    // adds the entry, or repoints an existing one
+    void insert(uint64_t order_id, OrderNode* node) {
+        if ((size_ + 1) * 4 > capacity_ * 3) grow(capacity_ ? capacity_ * 2 : MIN_CAPACITY);
+        size_t i = bucket(order_id);
+        for (; slots_[i].node; i = (i + 1) & mask_) {
+            if (slots_[i].order_id == order_id) {
+                slots_[i].node = node;
+                return;
+            }
+        }
+        slots_[i] = Slot{order_id, node};
+        ++size_;
+    }
+
+    bool erase(uint64_t order_id) {
+        if (size_ == 0) return false;
+        size_t i = bucket(order_id);
+        for (;; i = (i + 1) & mask_) {
+            if (!slots_[i].node) return false;
+            if (slots_[i].order_id == order_id) break;
+        }
+        erase_at(i);
+        return true;
+    }
+
+    // Erases every entry pred(order_id, node) selects in one sweep of the
+    // slot array, handing each node to on_erased(node) first. A pred that
+    // can decide from the id alone never touches the other nodes. A backward
+    // shift only moves entries into the slot being swept or over slots
+    // already kept, so every entry is judged at least once.
+    template<typename Pred, typename F>
+    void erase_if(Pred&& pred, F&& on_erased) {
+        for (size_t i = 0; i < capacity_ && size_ > 0;) {
+            if (slots_[i].node && pred(slots_[i].order_id, *slots_[i].node)) {
+                on_erased(slots_[i].node);
+                erase_at(i);  // may have pulled a later entry into i
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    // f(order_id, node) for every entry, in slot order
+    template<typename F>
+    void for_each(F&& f) const {
+        for (size_t i = 0; i < capacity_; i++)
+            if (slots_[i].node) f(slots_[i].order_id, slots_[i].node);
+    }
+
+    // empties the table in one sweep, keeping its capacity
+    void clear() {
+        for (size_t i = 0; i < capacity_; i++) slots_[i].node = nullptr;
+        size_ = 0;
+    }
+
+    // room for `orders` entries without growing
+    void reserve(size_t orders) {
+        size_t capacity = capacity_ ? capacity_ : MIN_CAPACITY;
+        while (orders * 4 > capacity * 3) capacity *= 2;
+        if (capacity > capacity_) grow(capacity);
+    }
+
+    size_t size()         const { return size_; }
+    size_t capacity()     const { return capacity_; }  // slots, not entries
+    size_t memory_bytes() const { return capacity_ * sizeof(Slot); }
+
+private:
+    struct Slot {
+        uint64_t   order_id;
+        OrderNode* node;
+    };
+
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t                  capacity_ = 0;
+    size_t                  mask_     = 0;
+    size_t                  size_     = 0;
+    unsigned                shift_    = 64;
+
+    // Fibonacci hashing: the top bits of id * 2^64/phi. Sequential ids and
+    // ids that differ only in their high (session) bits both spread evenly.
+    size_t bucket(uint64_t order_id) const {
+        return (size_t)((order_id * 0x9E3779B97F4A7C15ULL) >> shift_);
+    }
+
+    void erase_at(size_t hole) {
+        // pull back every later entry of the run whose home is at or before the hole
+        for (size_t j = (hole + 1) & mask_; slots_[j].node; j = (j + 1) & mask_) {
+            size_t home = bucket(slots_[j].order_id);
+            if (((j - home) & mask_) >= ((j - hole) & mask_)) {
+                slots_[hole] = slots_[j];
+                hole = j;
+            }
+        }
+        slots_[hole].node = nullptr;
+        --size_;
+    }
+
+    void grow(size_t capacity) {
+        std::unique_ptr<Slot[]> old = std::move(slots_);
+        size_t old_capacity = capacity_;
+
+        slots_    = std::make_unique<Slot[]>(capacity);  // value-initialised: all empty
+        capacity_ = capacity;
+        mask_     = capacity - 1;
+        shift_    = 64 - (unsigned)__builtin_ctzll(capacity);
+        size_     = 0;
+
+        for (size_t i = 0; i < old_capacity; i++)
+            if (old[i].node) insert(old[i].order_id, old[i].node);
+    }
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "order.hpp"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+class PriceLevel;
+
+// A resting order plus its intrusive FIFO links. Nodes never move once carved
+// out of a slab, so OrderNode* doubles as the order's handle everywhere.
+// Filling the front of a level reads the order, next and reserve, so those
+// come first; prev and level are only needed to unlink on cancel or amend.
+struct OrderNode {
+    Order       order;
+    OrderNode*  next;
+    uint64_t    reserve;  // iceberg quantity hidden behind order.quantity (the shown slice)
+    OrderNode*  prev;
+    PriceLevel* level;    // level the node is queued in, set by PriceLevel::add_order
+};
+
+static_assert(sizeof(OrderNode) == 80, "OrderNode must stay 80 bytes");
+static_assert(offsetof(OrderNode, reserve) + sizeof(uint64_t) <= 64,
+              "fields read by a fill must stay in the first 64 bytes");
+
+// Engine-wide slab allocator for OrderNodes. Slabs are fixed-size arrays that
+// are never freed or moved; released nodes go onto an intrusive free list and
+// are reused first, so a book at steady state never calls malloc.
+class OrderPool {
+public:
+    explicit OrderPool(size_t slab_size = 4096);
+
+    OrderNode* acquire(const Order& order);
+    void       release(OrderNode* node);
+
+    // grows capacity up front so the first n acquires do not hit malloc either
+    void reserve(size_t n);
+
+    size_t in_use()   const { return in_use_; }
+    size_t capacity() const { return slabs_.size() * slab_size_; }
+    size_t memory_bytes() const { return capacity() * sizeof(OrderNode); }
+
+private:
+    size_t                                    slab_size_;
+    std::vector<std::unique_ptr<OrderNode[]>> slabs_;
+    OrderNode*                                free_list_ = nullptr;  // threaded through next
+    size_t                                    in_use_    = 0;
+
+    void add_slab();
+};
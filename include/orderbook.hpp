@@ -1,81 +1,524 @@
 #pragma once
 
+#include "book_side.hpp"
+#include "instrument.hpp"
+#include "market_data.hpp"
+#include "metrics.hpp"
 #include "order.hpp"
+#include "order_index.hpp"
+#include "order_pool.hpp"
 #include "price_level.hpp"
 #include <cstdint>
 #include <functional>
-#include <map>
+#include <limits>
+#include <memory>
 #include <optional>
-#include <unordered_map>
+#include <type_traits>
 #include <vector>
 
+class PreTradeRisk;
+
 struct Trade {
     uint64_t buy_order_id;
     uint64_t sell_order_id;
-    double   price;
-    uint32_t quantity;
+    Price    price;
+    uint64_t quantity;
+    uint32_t buy_account;
+    uint32_t sell_account;
+};
+
+static_assert(sizeof(Trade) == 40, "Trade must stay 40 bytes");
+
+// Non-owning reference to any callable taking `const Trade&`. Two words, no
+// allocation; fills are handed to it in place as the matching loop produces
+// them. The callable only has to outlive the submit call it is passed to.
+class TradeSink {
+public:
+    template<typename F,
+             typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, TradeSink>>>
+    TradeSink(F&& f)
+        : ctx_((void*)std::addressof(f)),
+          fn_([](void* ctx, const Trade& trade) {
+              (*static_cast<std::remove_reference_t<F>*>(ctx))(trade);
+          }) {}
+
+    void operator()(const Trade& trade) const { fn_(ctx_, trade); }
+
+private:
+    void* ctx_;
+    void (*fn_)(void*, const Trade&);
+};
+
+// Bytes held for resting orders, to size hosts and watch the footprint over a
+// session. For a book, node_bytes counts the nodes its orders occupy; for an
+// Engine it is the whole shared pool, free nodes included.
+struct MemoryUsage {
+    size_t orders      = 0;  // resting orders
+    size_t node_bytes  = 0;  // OrderNodes
+    size_t index_bytes = 0;  // order-id table slots
+    size_t level_bytes = 0;  // price tree nodes, or ladder slots + occupancy bitmap
+
+    size_t total() const { return node_bytes + index_bytes + level_bytes; }
+    double bytes_per_order() const { return orders ? (double)total() / (double)orders : 0.0; }
+
+    MemoryUsage& operator+=(const MemoryUsage& o) {
+        orders      += o.orders;
+        node_bytes  += o.node_bytes;
+        index_bytes += o.index_bytes;
+        level_bytes += o.level_bytes;
+        return *this;
+    }
+};
+
+// Which resting orders a mass cancel takes. Every field narrows the
+// selection and a default filter takes the whole book; prices are inclusive.
+struct CancelFilter {
+    bool     bids      = true;
+    bool     asks      = true;
+    Price    min_price = std::numeric_limits<Price>::min();
+    Price    max_price = std::numeric_limits<Price>::max();
+    bool     by_owner  = false;
+    uint32_t owner     = 0;     // with by_owner, only orders whose owner_of(order_id) matches
+
+    static CancelFilter all() { return {}; }
+
+    static CancelFilter side(Side side) {
+        CancelFilter filter;
+        filter.bids = (side == Side::BUY);
+        filter.asks = (side == Side::SELL);
+        return filter;
+    }
+
+    static CancelFilter range(Side side, Price min_price, Price max_price) {
+        CancelFilter filter = CancelFilter::side(side);
+        filter.min_price    = min_price;
+        filter.max_price    = max_price;
+        return filter;
+    }
+
+    static CancelFilter owned_by(uint32_t owner) {
+        CancelFilter filter;
+        filter.by_owner = true;
+        filter.owner    = owner;
+        return filter;
+    }
+};
+
+// One summary per mass cancel in place of a result per order.
+struct MassCancelReport {
+    uint64_t orders   = 0;  // orders removed
+    uint64_t quantity = 0;  // their shown + hidden quantity
+    uint64_t levels   = 0;  // price levels they emptied, now gone
+
+    MassCancelReport& operator+=(const MassCancelReport& o) {
+        orders   += o.orders;
+        quantity += o.quantity;
+        levels   += o.levels;
+        return *this;
+    }
+};
+
+// How a call auction picks its price and how often it tells listeners.
+struct AuctionOptions {
+    // Last tie-break: the candidate nearest this price wins, the lower one
+    // when two are equally near. Without one the lowest candidate wins.
+    std::optional<Price> reference;
+
+    // recompute the indication after every this many changes to the call,
+    // and publish it to the listener when it moved
+    uint32_t indicate_every = 1;
 };
 
 class OrderBook {
 public:
+    // Resting orders live in `pool`, normally the Engine-wide one. A book built
+    // without a pool owns a private one.
+    explicit OrderBook(OrderPool* pool = nullptr);  // BookMode::MAP, any price accepted
+    OrderBook(BookMode mode, const InstrumentConfig& config, OrderPool* pool = nullptr);
+
+    // nodes are shared through raw handles, a copy would alias them
+    OrderBook(const OrderBook&)            = delete;
+    OrderBook& operator=(const OrderBook&) = delete;
+    OrderBook(OrderBook&&)                 = default;
+    OrderBook& operator=(OrderBook&&)      = default;
+
+    // Matches `order` and rests what is left of a GTC limit. IOC drops the
+    // remainder, FOK trades only if the whole quantity is available within its
+    // limit, post-only is dropped untraded if it would cross, and a limit with
+    // display_quantity rests as an iceberg showing that much at a time.
+    //
+    // STOP and STOP_LIMIT orders wait unseen in a trigger book keyed by
+    // stop_price. A trade printing at or above a buy stop's trigger, or at or
+    // below a sell stop's, elects it after the order that printed has
+    // finished: a STOP becomes a MARKET order and a STOP_LIMIT a LIMIT at
+    // `price`. Only trades after a stop arrives elect it. Elected stops run in
+    // election order: buy stops lowest trigger first, then sell stops highest
+    // first, FIFO at one trigger. Trades they print elect more stops, which
+    // queue behind, so a cascade settles before submit returns and every fill
+    // goes to on_trade.
+    // throws std::out_of_range in LADDER mode for a limit or stop price off the band or tick grid
+    void submit(Order order, TradeSink on_trade);
+
+    // Throws the std::out_of_range submit would for the order's prices, and
+    // changes nothing, so a caller can refuse an order before recording it.
+    void validate(const Order& order) const;
+
+    // convenience wrapper over the sink overload, allocates the result
     std::vector<Trade> submit(Order order);
     bool cancel(uint64_t order_id);
 
-    std::optional<double> best_bid() const;
-    std::optional<double> best_ask() const;
-    std::optional<double> spread()   const;
+    // Removes every resting order `filter` selects, in one pass rather than a
+    // lookup per order. Waiting stops are included, matched on their trigger.
+    // A side or price range walks its levels and drops each one it empties at
+    // once. An owner sweeps the order-id table, where the tag is part of the
+    // key. The whole book frees nodes straight from the table and resets every
+    // level. With a listener attached everything walks levels, so it still
+    // gets a DELETE per order and one update per level.
+    MassCancelReport mass_cancel(const CancelFilter& filter);
+
+    // Amends a resting order without a cancel/new round trip; the node, its
+    // order_id and its index entry are reused. A smaller quantity at the same
+    // price keeps queue priority. A larger quantity or a new price sends the
+    // order to the back of its level, and a new price that crosses matches
+    // first, fills to on_trade along with those of any stops it elects. For
+    // an iceberg `quantity` is shown plus hidden and a cut is taken from the
+    // hidden part first. quantity == 0 cancels. Returns false if order_id is
+    // not resting or is a waiting stop, or if a post-only order's new price
+    // would cross; that order keeps its place. Also reachable as an
+    // OrderType::MODIFY submit.
+    // throws std::out_of_range in LADDER mode for a new price off the band or tick grid
+    bool modify(uint64_t order_id, Price price, uint64_t quantity, TradeSink on_trade);
+
+    std::optional<Price> best_bid() const;
+    std::optional<Price> best_ask() const;
+    std::optional<Price> spread()   const;
+
+    // 0 for a price with no level, or off a LADDER book's band or tick grid
+    uint64_t bid_quantity_at(Price price) const;
+    uint64_t ask_quantity_at(Price price) const;
+
+    // Zero-copy depth walk. Visits levels on one side as
+    // f(price, const PriceLevel&), best first, until f returns false; iterate
+    // the PriceLevel itself for its orders in time priority.
+    template<typename F>
+    void for_each_level(Side side, F&& f) const {
+        with_sides([&](const auto& bids, const auto& asks) {
+            auto visit = [&](const auto& book_side) {
+                book_side.for_each_level([&](auto key, const PriceLevel& level) {
+                    return f(book_side.price_of(key), level);
+                });
+            };
+            if (side == Side::BUY) visit(bids);
+            else                   visit(asks);
+        });
+    }
+
+    // Visits every resting order on one side as f(price, const Order&), best
+    // price first and FIFO within a level. Nothing is copied.
+    template<typename F>
+    void for_each_order(Side side, F&& f) const {
+        for_each_level(side, [&](Price price, const PriceLevel& level) {
+            for (const Order& order : level) f(price, order);
+            return true;
+        });
+    }
+
+    // Call auction. From begin_auction() on nothing matches: limit orders
+    // rest even where they cross, market orders queue ahead of every limit
+    // on their side, and IOC and FOK orders are dropped since they cannot
+    // wait. Cancels and amends work as usual. Listeners get on_auction()
+    // whenever the indication moves.
+    //
+    // The uncross price is the limit price that executes the most volume,
+    // then leaves the smallest imbalance, then follows the pressure: the
+    // highest candidate if every one leaves buyers over, the lowest if every
+    // one leaves sellers over. Last comes AuctionOptions::reference. Prices
+    // are ranked from cumulative depth over the crossed levels only: two
+    // prefix sums over flat arrays and branch-free passes over the result.
+    void begin_auction(const AuctionOptions& options = {});
+
+    bool in_auction() const { return auction_; }
+
+    // where the call would uncross now; volume 0 outside a call or uncrossed
+    AuctionIndication indicative() const;
+
+    // Executes every fill at the uncross price in one pass, in price then
+    // time priority with market orders first, to on_trade. Market orders
+    // left over are cancelled, the book returns to continuous matching, and
+    // stops the auction print elects run before it returns. Returns what
+    // executed.
+    AuctionIndication uncross(TradeSink on_trade);
+
+    // Waiting stops of one side as f(stop_price, const PriceLevel&), in the
+    // order they would be elected, until f returns false.
+    template<typename F>
+    void for_each_stop_level(Side side, F&& f) const {
+        auto visit = [&](const auto& stops) {
+            stops.for_each_level([&](Price trigger, const PriceLevel& level) { return f(trigger, level); });
+        };
+        if (side == Side::BUY) visit(buy_stops_);
+        else                   visit(sell_stops_);
+    }
+
+    size_t stop_count() const { return stop_count_; }
+
+    // Best `n` levels of one side into out[], best first; returns how many.
+    size_t depth(Side side, DepthLevel* out, size_t n) const;
+    std::vector<DepthLevel> depth(Side side, size_t n) const;
+
+    // Cache hints for an order about to be submitted: the opposite side's best
+    // level and, in LADDER mode, the slot it would rest in.
+    void prefetch(const Order& order) const;
+
+    // Level changes are pushed to `listener` as they happen; nullptr detaches.
+    void set_listener(BookListener* listener) { listener_ = listener; }
 
-    uint32_t bid_quantity_at(double price) const;
-    uint32_t ask_quantity_at(double price) const;
+    // Stage timings and per-order counters go to `metrics`; nullptr detaches.
+    void set_metrics(EngineMetrics* metrics) { metrics_ = metrics; }
+
+    // Quantity that leaves unfilled goes to `risk`'s on_release, so its open
+    // exposure shrinks as the book's does; nullptr detaches.
+    void set_risk(PreTradeRisk* risk) { risk_ = risk; }
+
+    // Appends a resting order to the back of its level without matching, with
+    // `reserve` hidden behind it if it is an iceberg, or a stop to the back
+    // of its trigger. Used to restore a snapshot; the caller guarantees the
+    // book stays uncrossed.
+    void restore_order(const Order& order, uint64_t reserve = 0);
+
+    size_t order_count() const { return order_index_.size(); }  // waiting stops included
+
+    // The resting or waiting order with this id, nullptr if none. Valid until
+    // the book next changes.
+    const OrderNode* find(uint64_t order_id) const { return order_index_.find(order_id); }
+
+    // Sizes the order-id table for `orders` resting orders so it never grows
+    // mid-session. Nodes come from the pool; reserve those there.
+    void reserve(size_t orders) { order_index_.reserve(orders); }
+
+    MemoryUsage memory() const;
+
+    BookMode mode() const { return mode_; }
+    const InstrumentConfig& config() const { return config_; }
 
 private:
-    std::map<double, PriceLevel, std::greater<double>> bids_;
-    std::map<double, PriceLevel>                       asks_;
+    BookMode         mode_ = BookMode::MAP;
+    InstrumentConfig config_;
+
+    std::unique_ptr<OrderPool> own_pool_;
+    OrderPool*                 pool_;
+
+    PriceTree<std::greater<Price>> bids_;
+    PriceTree<std::less<Price>>    asks_;
+
+    PriceLadder<Side::BUY>  bid_ladder_;
+    PriceLadder<Side::SELL> ask_ladder_;
+
+    // the single order_id -> node index; the node knows its price, side and level.
+    // Every order leaves it the moment it leaves the book.
+    OrderIndex order_index_;
+
+    // Trigger book: waiting stops by stop_price, held in pool nodes like
+    // resting orders and indexed by order_id for cancel, but never matched
+    // against or published. The tree's best is the next to be elected.
+    PriceTree<std::less<Price>>    buy_stops_;
+    PriceTree<std::greater<Price>> sell_stops_;
+    size_t                         stop_count_ = 0;
+
+    // elected stops waiting their turn to match, oldest first
+    std::vector<Order> elected_;
 
-    struct OrderLocation {
-        double price;
-        Side   side;
+    // Call auction state. Market orders queue per side outside the price
+    // levels, on the heap so their nodes' level pointers survive the book
+    // moving; the scratch arrays are reused by every indication.
+    struct AuctionLadder {
+        std::vector<DepthLevel> bid_levels, ask_levels;  // as walked, best first, shown + hidden
+        std::vector<Price>    price;    // crossed level prices, ascending
+        std::vector<uint64_t> bids;     // bid quantity at price, then bids at or above it
+        std::vector<uint64_t> asks;     // ask quantity at price, then asks at or below it
+        std::vector<uint64_t> volume;   // min of the two
+        std::vector<uint64_t> surplus;  // |bids - asks|
     };
-    std::unordered_map<uint64_t, OrderLocation> order_map_;
 
-    std::vector<Trade> match_limit(Order& order);
-    std::vector<Trade> match_market(Order& order);
+    bool                    auction_ = false;
+    AuctionOptions          auction_options_;
+    std::vector<PriceLevel> auction_market_;  // by Side, sized by begin_auction
+    uint32_t                auction_changes_ = 0;
+    AuctionIndication       published_{};
+    mutable AuctionLadder   ladder_;
 
-    template<typename MapType>
-    std::vector<Trade> run_matching_loop(Order& order, MapType& passive_side) {
-        std::vector<Trade> trades;
+    BookListener*  listener_ = nullptr;
+    EngineMetrics* metrics_  = nullptr;
+    PreTradeRisk*  risk_     = nullptr;
 
-        while (order.quantity > 0 && !passive_side.empty()) {
-            auto        best_it   = passive_side.begin();
-            double      best_price = best_it->first;
-            PriceLevel& level      = best_it->second;
+    void level_changed(Price price, Side side, const PriceLevel& level) {
+        if (listener_) listener_->on_level(LevelUpdate{price, level.total_quantity(), side});
+    }
+
+    void order_event(OrderEventType type, const Order& order, Price price,
+                     uint64_t delta, uint32_t position) {
+        if (!listener_) return;
+        listener_->on_order(OrderEvent{
+            .order_id = order.order_id,
+            .price    = price,
+            .quantity = order.quantity,
+            .delta    = delta,
+            .position = position,
+            .type     = type,
+            .side     = (uint8_t)order.side,
+            .reserved = {}
+        });
+    }
+
+    // calls f(bids, asks) with the containers for the active mode
+    template<typename F>
+    decltype(auto) with_sides(F&& f) {
+        if (mode_ == BookMode::LADDER) return f(bid_ladder_, ask_ladder_);
+        return f(bids_, asks_);
+    }
+
+    template<typename F>
+    decltype(auto) with_sides(F&& f) const {
+        if (mode_ == BookMode::LADDER) return f(bid_ladder_, ask_ladder_);
+        return f(bids_, asks_);
+    }
+
+    // Side and order type are template parameters from here down: submit,
+    // cancel and modify branch on them once, and the matching path below
+    // carries no runtime test of either.
+    template<Side S, OrderType T, typename OwnSide, typename PassiveSide>
+    void execute(Order& order, OwnSide& own_side, PassiveSide& passive_side, TradeSink& on_trade);
+
+    // dispatches on side and order type into execute
+    void match(Order& order, TradeSink& on_trade);
+
+    void add_stop(const Order& order);
+    void cancel_stop(OrderNode* node);
+
+    void queue_for_auction(const Order& order);
+    void cancel_auction_market(OrderNode* node);
 
-            bool price_matches = (order.side == Side::BUY)
-                ? (order.price >= best_price)
-                : (order.price <= best_price);
+    // counts a change to the call and publishes the indication when due
+    void auction_changed();
 
-            if (!price_matches) break;
+    // candidate prices and cumulative depth into ladder_, then the pick
+    AuctionIndication compute_uncross() const;
 
-            const Order& resting    = level.get_front();
-            uint32_t     fill_qty   = std::min(order.quantity, resting.quantity);
+    template<typename Bids, typename Asks>
+    void execute_uncross(const AuctionIndication& at, Bids& bids, Asks& asks, TradeSink& on_trade);
+
+    // moves every stop a trade printed in [low, high] elects onto elected_
+    void elect_stops(Price low, Price high);
+
+    // matches elected_ in turn until no stop is left to run
+    void run_elected(TradeSink& on_trade);
+
+    template<typename StopTree>
+    void mass_cancel_stops(StopTree& stops, const CancelFilter& filter, bool unindex,
+                           MassCancelReport& report);
+
+    // would take liquidity right now (post-only check)
+    template<OrderType T, typename SideBook>
+    bool crosses(const Order& order, const SideBook& passive_side) const;
+
+    // the whole quantity is available within the limit (FOK check); sums
+    // aggregate level quantities, shown and hidden, without trial matching
+    template<OrderType T, typename SideBook>
+    bool fillable(const Order& order, const SideBook& passive_side) const;
+
+    template<typename SideBook>
+    void cancel_in(OrderNode* node, SideBook& own_side);
+
+    template<typename SideBook>
+    void mass_cancel_in(SideBook& own_side, Side side, const CancelFilter& filter, bool unindex,
+                        MassCancelReport& report);
+
+    template<typename SideBook>
+    void unlink_mass_cancelled(OrderNode* node, SideBook& own_side, MassCancelReport& report);
+
+    // false if the amend is refused and the order left as it was
+    template<Side S, typename OwnSide, typename PassiveSide>
+    bool modify_in(OrderNode* node, Price price, uint64_t quantity,
+                   OwnSide& own_side, PassiveSide& passive_side, TradeSink& on_trade);
+
+    // queues order at the back of its level and publishes ADD + level change
+    template<typename SideBook>
+    OrderNode* rest(const Order& order, SideBook& own_side);
+
+    template<typename SideBook>
+    void queue(OrderNode* node, SideBook& own_side);
+
+    void notify_add(const OrderNode* node, Price price);
+    void notify_delete(const Order& order, Price price, uint64_t removed,
+                       uint32_t position, const PriceLevel& level);
+    void release(const Order& order, uint64_t quantity);  // unfilled, to risk_
+
+    // S is the aggressor's side; a MARKET order carries no limit and sweeps
+    // until filled or the passive side is empty
+    template<Side S, OrderType T, typename SideBook>
+    void run_matching_loop(Order& order, SideBook& passive_side, TradeSink& on_trade) {
+        constexpr bool is_market = (T == OrderType::MARKET);
+        constexpr bool buying    = (S == Side::BUY);
+        constexpr Side passive   = buying ? Side::SELL : Side::BUY;
+
+        const auto limit     = passive_side.key_of(order.price);
+        const auto first_key = passive_side.empty() ? limit : passive_side.best_key();
+        uint32_t   fills     = 0;
+        uint32_t   levels    = 0;
+        auto       last_key  = limit;
+
+        while (order.quantity > 0 && !passive_side.empty()) {
+            auto        best_key = passive_side.best_key();
+            PriceLevel& level    = passive_side.best_level();
+
+            if constexpr (!is_market) {
+                if (!SideBook::within(best_key, limit)) break;
+            }
+            levels  += (fills == 0) | (best_key != last_key);
+            fills   += 1;
+            last_key = best_key;
+
+            const Order& resting    = level.head()->order;  // best level is never empty
+            uint64_t     fill_qty   = std::min(order.quantity, resting.quantity);
             uint64_t     resting_id = resting.order_id;
+            Price        price      = passive_side.price_of(best_key);
 
-            trades.push_back(Trade{
-                .buy_order_id  = (order.side == Side::BUY)  ? order.order_id : resting_id,
-                .sell_order_id = (order.side == Side::SELL) ? order.order_id : resting_id,
-                .price         = best_price,
-                .quantity      = fill_qty
+            on_trade(Trade{
+                .buy_order_id  = buying ? order.order_id : resting_id,
+                .sell_order_id = buying ? resting_id     : order.order_id,
+                .price         = price,
+                .quantity      = fill_qty,
+                .buy_account   = buying ? order.account   : resting.account,
+                .sell_account  = buying ? resting.account : order.account
             });
 
             order.quantity -= fill_qty;
-            level.fill_front(fill_qty);
 
-            if (level.is_empty()) {
-                order_map_.erase(resting_id);
-                passive_side.erase(best_it);
+            OrderNode* filled = level.fill_front(fill_qty);
+            order_event(OrderEventType::EXECUTE, resting, price, fill_qty, 0);
+            level_changed(price, passive, level);
+
+            if (filled && filled->reserve > 0) {
+                // iceberg: the next slice joins the back of the same level
+                level.replenish(filled);
+                notify_add(filled, price);
+            } else if (filled) {
+                order_index_.erase(resting_id);
+                pool_->release(filled);
+                if (level.is_empty()) passive_side.pop_best();
             }
         }
 
-        return trades;
+        // prints only move away from the first level, so these two bound them all
+        if (fills > 0 && stop_count_ > 0) {
+            Price first = passive_side.price_of(first_key);
+            Price last  = passive_side.price_of(last_key);
+            elect_stops(std::min(first, last), std::max(first, last));
+        }
+
+        if (metrics_) {
+            metrics_->fills_per_order.record(fills);
+            metrics_->levels_touched.record(levels);
+        }
     }
-};
\ No newline at end of file
+};
@@ -1,27 +1,100 @@
 #pragma once
 
 #include "order.hpp"
+#include "order_pool.hpp"
+#include <cstddef>
 #include <cstdint>
-#include <list>
-#include <unordered_map>
+#include <iterator>
 
+// FIFO queue at one price point, threaded through pool-owned OrderNodes.
+// The level never allocates and never owns nodes; the OrderBook acquires them
+// from the OrderPool and releases them once they leave the queue.
 class PriceLevel {
 public:
-    void add_order(const Order& order);
-    void cancel_order(uint64_t order_id);
-    void fill_front(uint32_t filled_quantity);
-    
+    void add_order(OrderNode* node);
+    void cancel_order(OrderNode* node);
+
+    // shrinks a queued order to new_quantity (0 < new_quantity < current) in place,
+    // keeping its place in the queue
+    void reduce_order(OrderNode* node, uint64_t new_quantity);
+
+    // shrinks an iceberg's hidden reserve in place; the shown slice is untouched
+    void reduce_reserve(OrderNode* node, uint64_t new_reserve);
+
+    // reduces the front order; returns it unlinked once fully filled, else nullptr
+    OrderNode* fill_front(uint64_t filled_quantity);
+
+    // re-queues a filled iceberg node at the back with its next shown slice
+    void replenish(OrderNode* node);
+
+    // Unlinks every order matching pred(const Order&) in one walk, front to
+    // back, and hands each to on_removed(node, position) straight after;
+    // position is its place in the queue at that moment. on_removed may
+    // release the node.
+    template<typename Pred, typename F>
+    void remove_if(Pred&& pred, F&& on_removed) {
+        uint32_t position = 0;
+        for (OrderNode* node = head_; node;) {
+            OrderNode* next = node->next;
+            if (pred(node->order)) {
+                cancel_order(node);
+                on_removed(node, position);
+            } else {
+                ++position;
+            }
+            node = next;
+        }
+    }
+
+    // forgets every queued order at once without touching the nodes; the
+    // caller has already released them
+    void reset() { *this = PriceLevel{}; }
+
     const Order& get_front() const;
-    
+
+    // FIFO walk: head() then node->next until nullptr
+    const OrderNode* head() const { return head_; }
+
+    // Forward iteration over the queued orders in time priority, by reference.
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = Order;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const Order*;
+        using reference         = const Order&;
+
+        explicit const_iterator(const OrderNode* node = nullptr) : node_(node) {}
+
+        reference operator*()  const { return node_->order; }
+        pointer   operator->() const { return &node_->order; }
+        const_iterator& operator++()    { node_ = node_->next; return *this; }
+        const_iterator  operator++(int) { const_iterator prev = *this; node_ = node_->next; return prev; }
+        bool operator==(const const_iterator& o) const { return node_ == o.node_; }
+        bool operator!=(const const_iterator& o) const { return node_ != o.node_; }
+
+    private:
+        const OrderNode* node_;
+    };
+
+    const_iterator begin() const { return const_iterator(head_); }
+    const_iterator end()   const { return const_iterator(); }
+
+    // 0-based place in the queue; walks toward the head, O(position)
+    uint32_t position_of(const OrderNode* node) const;
+
     bool is_empty() const;
-    uint32_t total_quantity() const;
+    uint64_t total_quantity() const;                          // shown quantity
+    uint64_t reserve_quantity() const { return reserve_qty_; } // hidden iceberg quantity
+    uint32_t order_count() const { return count_; }
 
 private:
     // the _ says that this is pvt, naming convention only.
-    std::list<Order> orders_;
+    OrderNode* head_ = nullptr;
+    OrderNode* tail_ = nullptr;
+    uint64_t total_qty_ = 0; // O(1) access
+    uint32_t count_ = 0;
+    uint64_t reserve_qty_ = 0;
 
-    // O(1) cancel index
-    // maps order_id -> iterator pointing into orders_ list
-    std::unordered_map<uint64_t, std::list<Order>::iterator> index_;
-    uint32_t total_qty_ = 0; // O(1) access
-};
\ No newline at end of file
+    void unlink(OrderNode* node);
+};
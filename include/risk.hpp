@@ -0,0 +1,247 @@
+#pragma once
+
+#include "order.hpp"
+#include "orderbook.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+// Outcome of a pre-trade check. Anything but ACCEPTED means the order reached
+// neither the journal nor the book.
+enum class RiskResult : uint8_t {
+    ACCEPTED,
+    UNKNOWN_ACCOUNT,
+    MAX_QUANTITY,
+    PRICE_COLLAR,
+    POSITION_LIMIT,
+    NOTIONAL_LIMIT,
+    RATE_LIMIT
+};
+
+const char* to_string(RiskResult result);
+
+// Checks a RiskGate compiles in; OR them into its template argument. A check
+// left out generates no code and its limits are ignored.
+namespace risk {
+enum Check : uint32_t {
+    MAX_QUANTITY = 1u << 0,  // order quantity
+    PRICE_COLLAR = 1u << 1,  // limit price vs the opposite touch
+    POSITION     = 1u << 2,  // net filled quantity if this order and every open one on its side filled
+    NOTIONAL     = 1u << 3,  // net filled notional if this order and every open one on its side filled
+    RATE         = 1u << 4,  // messages per rate window
+    ALL          = (1u << 5) - 1
+};
+}
+
+struct AccountLimits {
+    uint64_t max_order_quantity = std::numeric_limits<uint64_t>::max();
+    int64_t  max_position       = std::numeric_limits<int64_t>::max();
+    double   max_notional       = std::numeric_limits<double>::infinity();
+    double   price_collar       = 0.10;  // fraction of the touch a buy may pay above / a sell go below
+    uint32_t max_messages       = std::numeric_limits<uint32_t>::max();
+};
+
+// Everything one check reads or writes for an account, in two cache lines.
+// Positions are net across every instrument the account trades. Open
+// quantity is what accepted orders could still fill: it grows on accept and
+// shrinks on a fill, or when the book lets the rest go unfilled.
+struct alignas(64) AccountState {
+    int64_t  position;      // + long, - short
+    double   notional;      // signed, buys positive
+    uint64_t window_start;  // order timestamp that opened the current rate window
+    uint32_t window_count;
+    uint32_t max_messages;
+    uint64_t max_order_quantity;
+    int64_t  max_position;
+    double   max_notional;
+    double   price_collar;
+    uint64_t open_buys;
+    uint64_t open_sells;
+    double   open_buy_notional;
+    double   open_sell_notional;
+};
+
+static_assert(sizeof(AccountState) == 128, "account state must stay two cache lines");
+
+// Pre-trade stage called by Engine before an order is journaled or matched,
+// and fed every fill afterwards so position limits track executions. Books
+// report through on_release the quantity of an order that leaves them
+// unfilled: cancelled, amended down, or an unmatched remainder dropped.
+class PreTradeRisk {
+public:
+    virtual ~PreTradeRisk() = default;
+
+    virtual RiskResult check(const Order& order, const OrderBook& book) = 0;
+    virtual void       on_trade(const Trade& trade) = 0;
+    virtual void       on_release(const Order& order, uint64_t quantity) = 0;
+};
+
+// Per-account limits checked inline on the matching thread. The account table
+// is owned by that thread alone, so nothing is locked or atomic. Time comes
+// from Order::timestamp, which keeps decisions reproducible on replay.
+// Position and notional are checked at their worst: as if the order and every
+// open order on its side filled. Cancels pass unchecked. An amend is checked
+// against the resting order it targets, under that order's account: it counts
+// toward the rate, its new total quantity against the size cap, its new price
+// against the collar, and only a quantity increase against position and
+// notional, on top of the open quantity the order already holds.
+template<uint32_t Checks = risk::ALL>
+class RiskGate final : public PreTradeRisk {
+public:
+    explicit RiskGate(uint64_t rate_window_ns = 1'000'000'000) : window_ns_(rate_window_ns) {}
+
+    // registers or updates an account; ids are dense, the table grows to fit
+    void set_limits(uint32_t account, const AccountLimits& limits) {
+        if (account >= accounts_.size()) accounts_.resize(account + 1, AccountState{});
+        AccountState& a      = accounts_[account];
+        a.max_order_quantity = limits.max_order_quantity;
+        a.max_position       = limits.max_position;
+        a.max_notional       = limits.max_notional;
+        a.price_collar       = limits.price_collar;
+        a.max_messages       = limits.max_messages;
+        registered_.resize(accounts_.size(), false);
+        registered_[account] = true;
+    }
+
+    const AccountState& account(uint32_t account) const { return accounts_[account]; }
+
+    RiskResult check(const Order& order, const OrderBook& book) override {
+        // stops are checked once, on entry; the collar skips them, since they
+        // fire against a touch that has moved by design
+        if (order.type == OrderType::CANCEL) return RiskResult::ACCEPTED;
+        if (order.type == OrderType::MODIFY) return check_amend(order, book);
+        if (order.account >= accounts_.size() || !registered_[order.account]) return RiskResult::UNKNOWN_ACCOUNT;
+
+        AccountState& a = accounts_[order.account];
+        if (!within_rate(a, order.timestamp)) return RiskResult::RATE_LIMIT;
+        return check_limits(a, order, order.quantity, book);
+    }
+
+    void on_trade(const Trade& trade) override {
+        if constexpr ((Checks & (risk::POSITION | risk::NOTIONAL)) != 0) {
+            apply(trade.buy_account,  (int64_t)trade.quantity, trade.price);
+            apply(trade.sell_account, -(int64_t)trade.quantity, trade.price);
+            release(trade.buy_account,  Side::BUY,  trade.quantity);
+            release(trade.sell_account, Side::SELL, trade.quantity);
+        }
+    }
+
+    void on_release(const Order& order, uint64_t quantity) override {
+        if constexpr ((Checks & (risk::POSITION | risk::NOTIONAL)) != 0) {
+            release(order.account, order.side, quantity);
+        }
+    }
+
+private:
+    std::vector<AccountState> accounts_;    // indexed by Order::account
+    std::vector<bool>         registered_;  // set_limits called; kept off the hot line
+    uint64_t                  window_ns_;
+
+    bool within_rate(AccountState& a, uint64_t timestamp) {
+        if constexpr ((Checks & risk::RATE) != 0) {
+            if (timestamp - a.window_start >= window_ns_) {
+                a.window_start = timestamp;
+                a.window_count = 0;
+            }
+            return ++a.window_count <= a.max_messages;
+        }
+        return true;
+    }
+
+    // an amend carries only id, price and quantity; side and account come
+    // from the order it targets. An id the book does not hold passes, the
+    // book refuses it anyway.
+    RiskResult check_amend(const Order& amend, const OrderBook& book) {
+        const OrderNode* node = book.find(amend.order_id);
+        if (!node) return RiskResult::ACCEPTED;
+
+        const Order& resting = node->order;
+        if (resting.account >= accounts_.size() || !registered_[resting.account]) return RiskResult::UNKNOWN_ACCOUNT;
+
+        AccountState& a = accounts_[resting.account];
+        if (!within_rate(a, amend.timestamp)) return RiskResult::RATE_LIMIT;
+        if (resting.type != OrderType::LIMIT || amend.quantity == 0) return RiskResult::ACCEPTED;  // refused, or a cancel
+
+        Order amended    = resting;
+        amended.price    = amend.price;
+        amended.quantity = amend.quantity;
+        uint64_t before  = resting.quantity + node->reserve;
+        return check_limits(a, amended, amend.quantity > before ? amend.quantity - before : 0, book);
+    }
+
+    // `order` as it would stand; `added` is the quantity it adds to the
+    // account's open exposure, all of it for a new order. Nothing added,
+    // nothing to check against position or notional. Accepted, `added`
+    // becomes open.
+    RiskResult check_limits(AccountState& a, const Order& order, uint64_t added, const OrderBook& book) {
+        if constexpr ((Checks & risk::MAX_QUANTITY) != 0) {
+            if (order.quantity > a.max_order_quantity) return RiskResult::MAX_QUANTITY;
+        }
+
+        const bool buy            = (order.side == Side::BUY);
+        const bool adds           = added > 0;
+        double     added_notional = 0;
+
+        if constexpr ((Checks & (risk::PRICE_COLLAR | risk::NOTIONAL)) != 0) {
+            std::optional<Price> touch = buy ? book.best_ask() : book.best_bid();
+
+            if constexpr ((Checks & risk::PRICE_COLLAR) != 0) {
+                if (order.type == OrderType::LIMIT && touch) {
+                    double limit = (double)order.price;
+                    if (buy  && limit > (double)*touch * (1.0 + a.price_collar)) return RiskResult::PRICE_COLLAR;
+                    if (!buy && limit < (double)*touch * (1.0 - a.price_collar)) return RiskResult::PRICE_COLLAR;
+                }
+            }
+
+            if constexpr ((Checks & risk::NOTIONAL) != 0) {
+                const bool limited = (order.type == OrderType::LIMIT || order.type == OrderType::STOP_LIMIT);
+                Price      price   = limited ? order.price : touch.value_or(0);
+                added_notional     = (double)added * to_double(price);
+                double worst = buy ? a.notional + a.open_buy_notional + added_notional
+                                   : a.notional - a.open_sell_notional - added_notional;
+                if (adds && std::fabs(worst) > a.max_notional) return RiskResult::NOTIONAL_LIMIT;
+            }
+        }
+
+        if constexpr ((Checks & risk::POSITION) != 0) {
+            int64_t worst = buy ? a.position + (int64_t)(a.open_buys + added)
+                                : a.position - (int64_t)(a.open_sells + added);
+            if (adds && (worst > a.max_position || -worst > a.max_position)) return RiskResult::POSITION_LIMIT;
+        }
+
+        if constexpr ((Checks & (risk::POSITION | risk::NOTIONAL)) != 0) {
+            if (buy) {
+                a.open_buys         += added;
+                a.open_buy_notional += added_notional;
+            } else {
+                a.open_sells         += added;
+                a.open_sell_notional += added_notional;
+            }
+        }
+        return RiskResult::ACCEPTED;
+    }
+
+    void apply(uint32_t account, int64_t quantity, Price price) {
+        if (account >= accounts_.size()) return;
+        accounts_[account].position += quantity;
+        accounts_[account].notional += (double)quantity * to_double(price);
+    }
+
+    // Open notional goes at the side's average price, so an order released at
+    // any price, or a market order that had none, leaves the rest consistent.
+    // Orders accepted before the gate was attached never became open; what
+    // they release is capped at what is there.
+    void release(uint32_t account, Side side, uint64_t quantity) {
+        if (account >= accounts_.size()) return;
+        AccountState& a        = accounts_[account];
+        uint64_t&     open     = (side == Side::BUY) ? a.open_buys : a.open_sells;
+        double&       notional = (side == Side::BUY) ? a.open_buy_notional : a.open_sell_notional;
+        if (open == 0) return;
+        uint64_t gone = std::min(quantity, open);
+        notional = (gone == open) ? 0 : notional * (double)(open - gone) / (double)open;
+        open    -= gone;
+    }
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "engine.hpp"
+#include "spsc_queue.hpp"
+#include "symbol_registry.hpp"
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class ReportType : uint8_t {
+    FILL,
+    REJECT  // the shard's risk gate refused the message, or a LADDER book
+            // did: price off its band or tick grid
+};
+
+// Outbound fill or reject, tagged with the global instrument id.
+struct ExecutionReport {
+    InstrumentId instrument;
+    ReportType   type     = ReportType::FILL;
+    RiskResult   risk     = RiskResult::ACCEPTED;  // REJECT: the verdict, ACCEPTED for a bad price
+    uint64_t     order_id = 0;  // REJECT: the refused order, cancel or amend
+    Trade        trade{};       // FILL
+};
+
+// Partitions instruments across N matching threads. Each shard owns a private
+// Engine (books + order pool) and is pinned to a core; messages reach it
+// through an SPSC inbound ring and fills leave through an SPSC outbound ring.
+// An instrument always maps to the same shard, so per-symbol order is the
+// order of submit() calls.
+//
+// Threading contract: add_symbol() only before start(); submit()/cancel()/modify()
+// from one producer thread; poll() from one consumer thread, which must keep
+// draining while stop() runs or a full outbound ring will stall its shard.
+class ShardedEngine {
+public:
+    // shard i is pinned to core (first_core + i) % hardware_concurrency;
+    // first_core < 0 disables pinning
+    explicit ShardedEngine(size_t num_shards, size_t queue_capacity = 1 << 16,
+                           int first_core = 0);
+    ~ShardedEngine();
+
+    ShardedEngine(const ShardedEngine&)            = delete;
+    ShardedEngine& operator=(const ShardedEngine&) = delete;
+
+    InstrumentId add_symbol(const std::string& symbol);  // MAP-mode book
+    InstrumentId add_symbol(const std::string& symbol, const InstrumentConfig& config,
+                            BookMode mode = BookMode::LADDER);
+    std::optional<InstrumentId> find_symbol(const std::string& symbol) const;
+
+    // pre-trade risk for one shard's engine, before start(); the gate then
+    // belongs to that shard's thread, so an account's limits apply per shard
+    void set_risk(size_t shard, PreTradeRisk* risk);
+
+    // instrumentation for one shard's engine, before start(); report() is
+    // safe from any thread while the shard runs
+    void set_metrics(size_t shard, EngineMetrics* metrics);
+
+    void start();
+    // stops accepting work once every inbound ring is drained, then joins
+    void stop();
+
+    // Spin while the target shard's inbound ring is full. A message its risk
+    // gate or its book refuses comes back from poll() as a REJECT report.
+    void submit(InstrumentId id, const Order& order);
+    void cancel(InstrumentId id, uint64_t order_id);
+    void modify(InstrumentId id, uint64_t order_id, Price price, uint64_t quantity);
+
+    // hands every queued report to on_report, returns how many were drained
+    template<typename F>
+    size_t poll(F&& on_report) {
+        size_t          drained = 0;
+        ExecutionReport report;
+        for (auto& shard : shards_) {
+            while (shard->outbound.try_pop(report)) {
+                on_report(report);
+                ++drained;
+            }
+        }
+        return drained;
+    }
+
+    size_t shard_count() const { return shards_.size(); }
+    size_t shard_of(InstrumentId id) const { return routes_[id].shard; }
+
+private:
+    struct Shard {
+        Shard(size_t queue_capacity) : inbound(queue_capacity), outbound(queue_capacity) {}
+
+        Engine                      engine;
+        std::vector<InstrumentId>   global_ids;  // shard-local id -> global id
+        SpscQueue<OrderMessage>     inbound;
+        SpscQueue<ExecutionReport>  outbound;
+        std::thread                 thread;
+    };
+
+    struct Route {
+        uint32_t     shard;
+        InstrumentId local;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    SymbolRegistry                      symbols_;
+    std::vector<Route>                  routes_;  // indexed by global id
+    int                                 first_core_;
+    std::atomic<bool>                   running_{false};
+
+    InstrumentId route(const std::string& symbol, Shard& shard, InstrumentId local);
+    void run(Shard& shard);
+};
@@ -0,0 +1,267 @@
+#pragma once
+
+#include "engine.hpp"
+#include "metrics.hpp"
+#include "spsc_queue.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Shared-memory order entry for co-located processes. One POSIX shared memory
+// object holds a header, an MPSC ring of inbound orders and a broadcast ring
+// of trades, level updates and rejects. Every slot is one cache line and
+// carries its own sequence number, so producers and readers synchronise on
+// the slot they touch and never on a shared lock.
+//
+//   orders : Vyukov bounded MPSC. A producer claims a position with one CAS
+//            on the tail, writes the slot and publishes it by storing the
+//            position + 1 into the slot's sequence. The consumer frees a slot
+//            by storing position + capacity.
+//   events : single writer, any number of readers, each with a private
+//            cursor. Slots are seqlocks; a reader that falls a whole ring
+//            behind skips ahead and counts what it lost instead of stalling
+//            the matching thread.
+//
+// Sequences are 32-bit and compared by signed difference, so they wrap
+// harmlessly as long as a ring holds fewer than 2^31 slots. The TSC stamps
+// assume an invariant TSC shared by all cores, true of current x86 servers.
+
+enum class ShmWait : uint8_t {
+    SPIN,   // busy-poll forever: lowest latency, burns the core
+    FUTEX   // spin briefly, then sleep on a futex in the shared header
+};
+
+struct ShmOptions {
+    uint32_t order_slots = 1 << 16;  // rounded up to a power of two
+    uint32_t event_slots = 1 << 16;
+    ShmWait  wait        = ShmWait::FUTEX;
+    unsigned spin_polls  = 1000;     // FUTEX: empty polls before sleeping
+    bool     level_updates = true;   // publish LevelUpdate events for every book
+};
+
+struct alignas(64) ShmOrderSlot {
+    std::atomic<uint32_t> sequence;
+    InstrumentId          instrument;
+    Order                 order;
+    uint64_t              sent_tsc;   // tsc_now() when the producer claimed the slot
+};
+
+enum class ShmEventType : uint8_t {
+    TRADE  = 1,
+    LEVEL  = 2,   // aggregate level change, quantity 0 = level gone
+    REJECT = 3    // order refused: risk verdict or bad price
+};
+
+struct ShmEvent {
+    ShmEventType type;
+    RiskResult   risk;        // REJECT: the verdict, ACCEPTED for a bad price
+    uint8_t      reserved[2];
+    InstrumentId instrument;
+    uint64_t     sent_tsc;    // when the matching thread published it
+    union {
+        Trade       trade;
+        LevelUpdate level;
+        uint64_t    order_id; // REJECT
+    };
+};
+
+struct alignas(64) ShmEventSlot {
+    std::atomic<uint32_t> sequence;   // index + 1 once written, 0 while being written
+    uint32_t              reserved;
+    ShmEvent              event;
+};
+
+static_assert(sizeof(ShmOrderSlot) == 64 && sizeof(ShmEventSlot) == 64, "shm slots must stay one cache line");
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "shared-memory atomics must be lock-free to be address-free");
+
+struct alignas(64) ShmHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t order_slots;
+    uint32_t event_slots;
+    uint32_t reserved;
+
+    alignas(64) std::atomic<uint64_t> order_tail;     // next position producers claim
+    alignas(64) std::atomic<uint64_t> order_head;     // next position the consumer reads
+    std::atomic<uint32_t>             order_futex;    // bumped to wake a sleeping consumer
+    std::atomic<uint32_t>             order_sleeping;
+
+    alignas(64) std::atomic<uint64_t> event_tail;     // events published so far
+    std::atomic<uint32_t>             event_futex;
+    std::atomic<uint32_t>             event_sleepers; // readers currently asleep
+};
+
+// A mapped shared memory object laid out as ShmHeader + order slots + event
+// slots. The creating side owns the name and unlinks it on destruction.
+class ShmChannel {
+public:
+    // create == true: make (or replace) the object; false: attach to an existing one
+    ShmChannel(const std::string& name, bool create, const ShmOptions& options = {});
+    ~ShmChannel();
+
+    ShmChannel(const ShmChannel&)            = delete;
+    ShmChannel& operator=(const ShmChannel&) = delete;
+
+    ShmHeader&    header() const { return *header_; }
+    ShmOrderSlot* orders() const { return orders_; }
+    ShmEventSlot* events() const { return events_; }
+
+private:
+    std::string   name_;
+    bool          owner_;
+    void*         base_ = nullptr;
+    size_t        size_ = 0;
+    ShmHeader*    header_ = nullptr;
+    ShmOrderSlot* orders_ = nullptr;
+    ShmEventSlot* events_ = nullptr;
+};
+
+// futex on a word in shared memory (not FUTEX_PRIVATE: other processes wake it)
+void shm_futex_wait(std::atomic<uint32_t>& word, uint32_t expected);
+void shm_futex_wake(std::atomic<uint32_t>& word);
+
+// Consumes the order ring on its own matching thread and runs every message
+// through `engine`. Trades, rejects and (optionally) level updates of every
+// book go out on the event ring. Register symbols before start(), and leave
+// the Engine alone until stop() returns.
+class ShmGateway {
+public:
+    ShmGateway(Engine& engine, const std::string& name, ShmOptions options = {});
+    ~ShmGateway();
+
+    ShmGateway(const ShmGateway&)            = delete;
+    ShmGateway& operator=(const ShmGateway&) = delete;
+
+    // ticks from a producer's claim to the matching thread's pop; before start()
+    void set_latency(Histogram* inbound) { latency_ = inbound; }
+
+    // core < 0 leaves the matching thread unpinned
+    void start(int core = -1);
+    // finishes what producers have already published, then joins
+    void stop();
+
+    uint64_t processed() const { return processed_.load(std::memory_order_relaxed); }
+
+private:
+    class LevelPublisher;
+
+    Engine&                                      engine_;
+    ShmOptions                                   options_;
+    ShmChannel                                   channel_;
+    std::vector<std::unique_ptr<LevelPublisher>> publishers_;
+    Histogram*                                   latency_ = nullptr;
+    uint64_t                                     next_event_ = 0;
+
+    std::thread           thread_;
+    std::atomic<bool>     running_{false};
+    std::atomic<uint64_t> processed_{0};
+
+    void run();
+    bool try_pop(OrderMessage& out, uint64_t& sent_tsc);
+    void publish(ShmEvent& event);
+    void reject(InstrumentId instrument, uint64_t order_id, RiskResult risk);
+    void wake_readers();
+};
+
+// A producer and reader process. Any number of clients may submit at once;
+// each reads the whole event stream from the point it attached.
+class ShmClient {
+public:
+    explicit ShmClient(const std::string& name, ShmWait wait = ShmWait::FUTEX, unsigned spin_polls = 1000);
+
+    // false when the order ring is full
+    bool try_submit(InstrumentId instrument, const Order& order) {
+        ShmHeader&    h    = channel_.header();
+        ShmOrderSlot* ring = channel_.orders();
+        uint64_t      pos  = h.order_tail.load(std::memory_order_relaxed);
+
+        for (;;) {
+            ShmOrderSlot& slot = ring[pos & order_mask_];
+            int32_t diff = (int32_t)(slot.sequence.load(std::memory_order_acquire) - (uint32_t)pos);
+            if (diff == 0) {
+                if (h.order_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;  // the consumer has not freed this lap's slot yet
+            } else {
+                pos = h.order_tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        ShmOrderSlot& slot = ring[pos & order_mask_];
+        slot.instrument = instrument;
+        slot.order      = order;
+        slot.sent_tsc   = tsc_now();
+        slot.sequence.store((uint32_t)(pos + 1), std::memory_order_release);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (h.order_sleeping.load(std::memory_order_relaxed)) {
+            h.order_futex.fetch_add(1, std::memory_order_relaxed);
+            shm_futex_wake(h.order_futex);
+        }
+        return true;
+    }
+
+    // spins while the order ring is full
+    void submit(InstrumentId instrument, const Order& order) {
+        Backoff backoff;
+        while (!try_submit(instrument, order)) backoff.pause();
+    }
+
+    // Hands each new event to on_event and returns how many. With `wait`, blocks
+    // (per the wait mode) until at least one arrives.
+    template<typename F>
+    size_t poll(F&& on_event, bool wait = false) {
+        size_t handled = 0;
+        ShmEvent event;
+        for (;;) {
+            while (read_next(event)) {
+                on_event(event);
+                ++handled;
+            }
+            if (handled || !wait) return handled;
+            idle();
+        }
+    }
+
+    uint64_t lost() const { return lost_; }  // events overwritten before this reader got to them
+
+private:
+    ShmChannel channel_;
+    ShmWait    wait_;
+    unsigned   spin_polls_;
+    uint64_t   order_mask_;
+    uint64_t   event_mask_;
+    uint64_t   cursor_;
+    uint64_t   lost_ = 0;
+    unsigned   idle_polls_ = 0;
+
+    bool read_next(ShmEvent& out) {
+        ShmEventSlot& slot = channel_.events()[cursor_ & event_mask_];
+        uint32_t before = slot.sequence.load(std::memory_order_acquire);
+        int32_t  ahead  = (int32_t)(before - (uint32_t)(cursor_ + 1));
+        if (before == 0 || ahead < 0) return false;  // not written yet (or being rewritten)
+        if (ahead > 0) {
+            skip_lapped();
+            return false;
+        }
+
+        std::memcpy(&out, &slot.event, sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != before) {
+            skip_lapped();  // overwritten while we copied
+            return false;
+        }
+        ++cursor_;
+        idle_polls_ = 0;
+        return true;
+    }
+
+    void skip_lapped();
+    void idle();
+};
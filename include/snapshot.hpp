@@ -0,0 +1,74 @@
+#pragma once
+
+#include "instrument.hpp"
+#include "order.hpp"
+#include <cstdint>
+#include <future>
+#include <string>
+#include <vector>
+
+class Engine;
+
+// Point-in-time image of every book in an Engine. Layout, host byte order:
+//
+//   SnapshotHeader
+//   per book: SnapshotBook, then bid_orders + ask_orders SnapshotOrders
+//
+// Orders are stored best price first and FIFO within a level, bids then asks,
+// so consecutive orders sharing a price form one PriceLevel and appending them
+// in file order rebuilds every queue and the order_id index exactly. Each
+// side's waiting stops follow its resting orders, in election order.
+struct SnapshotHeader {
+    char     magic[8];          // "OBSNAP\0\1"
+    uint32_t version;
+    uint32_t book_count;
+    uint64_t journal_sequence;  // first journal record not reflected in the image
+    uint64_t order_count;
+    uint8_t  reserved[32];
+};
+
+struct SnapshotBook {
+    char     name[20];
+    uint32_t mode;
+    int64_t  tick_size;  // fixed point, as InstrumentConfig
+    int64_t  min_price;
+    int64_t  max_price;
+    uint64_t bid_orders;
+    uint64_t ask_orders;
+};
+
+struct SnapshotOrder {
+    uint64_t order_id;
+    uint64_t timestamp;
+    int64_t  price;             // fixed point, see Price
+    uint64_t quantity;          // shown
+    uint64_t reserve;           // iceberg quantity hidden behind it
+    uint64_t display_quantity;  // iceberg peak, 0 = not an iceberg; a stop's trigger price
+    uint32_t account;
+    uint8_t  side;
+    uint8_t  type;
+    uint8_t  tif;               // matters for a stop, which matches when elected
+    uint8_t  post_only;
+};
+
+static_assert(sizeof(SnapshotHeader) == 64, "snapshot header must stay 64 bytes");
+static_assert(sizeof(SnapshotBook)   == 64, "snapshot book header must stay 64 bytes");
+static_assert(sizeof(SnapshotOrder)  == 56, "snapshot orders must stay 56 bytes");
+
+// Serialises every book into memory. This is the only part that has to run on
+// the matching thread: a linear walk and a 56-byte copy per resting order.
+// Throws std::logic_error while a book is in a call auction, whose crossed
+// levels and queued market orders the format cannot hold.
+std::vector<char> capture_snapshot(const Engine& engine);
+
+// Writes an image to path via a temp file + fsync + rename, so a reader never
+// sees a half-written snapshot. Safe to call from any thread.
+void write_snapshot(const std::string& path, const std::vector<char>& image);
+
+// capture_snapshot() now, write_snapshot() on a background thread.
+std::future<void> save_snapshot_async(const Engine& engine, const std::string& path);
+
+// Maps a snapshot and rebuilds its books into a fresh engine by appending each
+// order to its level directly, without matching. Returns the journal sequence
+// to resume replay from. Throws std::runtime_error on a bad or truncated file.
+uint64_t load_snapshot(const std::string& path, Engine& engine);
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Spin-wait hint for busy-poll loops.
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// Busy-poll with a bounded spin before yielding, so pinned threads stay hot
+// while oversubscribed ones (more shards than cores) still make progress.
+class Backoff {
+public:
+    void pause() {
+        if (spins_ < 64) { ++spins_; cpu_relax(); }
+        else             { std::this_thread::yield(); }
+    }
+    void reset() { spins_ = 0; }
+
+private:
+    unsigned spins_ = 0;
+};
+
+// Bounded lock-free single-producer/single-consumer ring. Capacity is rounded
+// up to a power of two. Producer and consumer indices live on separate cache
+// lines and each side caches the other's index, so the shared lines are only
+// touched when the cached view says the ring looks full or empty.
+template<typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&)            = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // producer side
+    bool try_push(const T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ > mask_) return false;
+        }
+        slots_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side
+    bool try_pop(T& out) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) return false;
+        }
+        out = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // safe from either side, exact only when the other side is quiescent
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    std::vector<T> slots_;
+    size_t         mask_ = 0;
+
+    alignas(64) std::atomic<size_t> head_{0};   // written by consumer
+    size_t                          tail_cache_ = 0;
+    alignas(64) std::atomic<size_t> tail_{0};   // written by producer
+    size_t                          head_cache_ = 0;
+};
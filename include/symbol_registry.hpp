@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Dense per-engine instrument handle, 0..N-1 in registration order.
+using InstrumentId = uint32_t;
+
+// Maps symbol names to dense InstrumentIds. Interning happens once per symbol
+// (normally at session start); everything downstream indexes by id.
+class SymbolRegistry {
+public:
+    // existing id for symbol, or the next dense id if it is new
+    InstrumentId intern(const std::string& symbol);
+
+    std::optional<InstrumentId> find(const std::string& symbol) const;
+
+    const std::string& name(InstrumentId id) const { return names_[id]; }
+    size_t size() const { return names_.size(); }
+
+private:
+    std::unordered_map<std::string, InstrumentId> ids_;
+    std::vector<std::string>                      names_;
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hierarchical occupancy bitmap over a fixed range of ticks. Layer 0 has one
+// bit per tick; a bit in layer k+1 is set iff word it stands for in layer k is
+// non-zero. With 64-way fan-out three layers cover 262144 ticks, so next() and
+// prev() cost a handful of ctz/clz instructions however far apart set ticks are.
+class TickBitmap {
+public:
+    static constexpr int64_t NONE = -1;
+
+    TickBitmap() = default;
+
+    explicit TickBitmap(size_t bits) {
+        size_t words = words_for(bits);
+        do {
+            layers_.emplace_back(words, 0);
+            words = words_for(words);
+        } while (layers_.back().size() > 1);
+    }
+
+    bool test(int64_t bit) const {
+        return (layers_[0][(size_t)bit >> 6] >> (bit & 63)) & 1;
+    }
+
+    void set(int64_t bit) {
+        size_t i = (size_t)bit;
+        for (std::vector<uint64_t>& layer : layers_) {
+            uint64_t& word    = layer[i >> 6];
+            bool      was_set = word != 0;
+            word |= uint64_t(1) << (i & 63);
+            if (was_set) return;  // the layers above already know this word is occupied
+            i >>= 6;
+        }
+    }
+
+    void clear(int64_t bit) {
+        size_t i = (size_t)bit;
+        for (std::vector<uint64_t>& layer : layers_) {
+            uint64_t& word = layer[i >> 6];
+            word &= ~(uint64_t(1) << (i & 63));
+            if (word != 0) return;
+            i >>= 6;
+        }
+    }
+
+    // lowest set bit >= from, or NONE
+    int64_t next(int64_t from) const {
+        if (from < 0) from = 0;
+        size_t i = (size_t)from;
+        size_t k = 0;
+
+        // climb until a word has a set bit at or after i
+        for (;;) {
+            const std::vector<uint64_t>& layer = layers_[k];
+            if ((i >> 6) >= layer.size()) return NONE;
+            uint64_t bits = layer[i >> 6] & (~uint64_t(0) << (i & 63));
+            if (bits) {
+                i = (i & ~size_t(63)) | (size_t)__builtin_ctzll(bits);
+                break;
+            }
+            if (++k == layers_.size()) return NONE;
+            i = (i >> 6) + 1;
+        }
+
+        // descend to the lowest set tick under it
+        while (k-- > 0) i = (i << 6) | (size_t)__builtin_ctzll(layers_[k][i]);
+        return (int64_t)i;
+    }
+
+    // highest set bit <= from, or NONE
+    int64_t prev(int64_t from) const {
+        if (from < 0) return NONE;
+        size_t i = (size_t)from;
+        size_t k = 0;
+
+        if ((i >> 6) >= layers_[0].size()) i = layers_[0].size() * 64 - 1;
+
+        for (;;) {
+            uint64_t bits = layers_[k][i >> 6] & (~uint64_t(0) >> (63 - (i & 63)));
+            if (bits) {
+                i = (i & ~size_t(63)) | (size_t)(63 - __builtin_clzll(bits));
+                break;
+            }
+            if (++k == layers_.size() || (i >> 6) == 0) return NONE;
+            i = (i >> 6) - 1;
+        }
+
+        while (k-- > 0) i = (i << 6) | (size_t)(63 - __builtin_clzll(layers_[k][i]));
+        return (int64_t)i;
+    }
+
+    size_t memory_bytes() const {
+        size_t bytes = 0;
+        for (const std::vector<uint64_t>& layer : layers_) bytes += layer.capacity() * sizeof(uint64_t);
+        return bytes;
+    }
+
+private:
+    std::vector<std::vector<uint64_t>> layers_;  // [0] is one bit per tick
+
+    static size_t words_for(size_t bits) { return (bits + 63) / 64; }
+};
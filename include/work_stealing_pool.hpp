@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+// Fork-join pool for a fixed set of independent tasks of uneven size, such as
+// one book's whole history each. run() deals the tasks out round-robin to one
+// deque per worker, biggest first when costs are given. A worker takes its own
+// tasks biggest first and, once out, steals the smallest left in another's,
+// so the big tasks start early and the small ones even out the finish.
+// Tasks run for milliseconds to minutes, so each deque is a plain mutex-guarded
+// array and workers are started per run(). The calling thread is worker 0.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(size_t threads = 0);  // 0 = one per hardware thread
+
+    size_t threads() const { return threads_; }
+
+    // Calls task(i) exactly once for every i in [0, count) and returns when all
+    // have finished. cost[i], if given, is task i's expected size. The first
+    // exception a task throws is rethrown here once the others have stopped.
+    template<typename F>
+    void run(size_t count, F&& task, const uint64_t* cost = nullptr) {
+        run_erased(count, cost, (void*)std::addressof(task), [](void* ctx, size_t i) {
+            (*static_cast<std::remove_reference_t<F>*>(ctx))(i);
+        });
+    }
+
+    uint64_t steals() const { return steals_; }  // tasks taken from another worker, all runs
+
+private:
+    size_t   threads_;
+    uint64_t steals_ = 0;
+
+    void run_erased(size_t count, const uint64_t* cost, void* ctx, void (*fn)(void*, size_t));
+};
@@ -1,6 +1,22 @@
+#include <algorithm>
+#include <deque>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include "include/backtest.hpp"
 #include "include/engine.hpp"
+#include "include/flow.hpp"
+#include "include/gateway.hpp"
+#include "include/journal.hpp"
+#include "include/sharded_engine.hpp"
+#include "include/shm_ring.hpp"
+#include "include/snapshot.hpp"
+#include <cstdio>
+#include <sys/wait.h>
+#include <unistd.h>
 
 uint64_t next_id() {
     static uint64_t id = 1;
@@ -9,18 +25,19 @@ uint64_t next_id() {
 
 uint64_t now_ns() {
     struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
+    clock_gettime(CLOCK_MONOTONIC, &ts);
     return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
 }
 
 Order make_order(Side side, OrderType type, double price, uint32_t qty) {
     return Order{
-        .order_id  = next_id(),
-        .timestamp = now_ns(),
-        .price     = price,
-        .quantity  = qty,
-        .side      = side,
-        .type      = type
+        .order_id         = next_id(),
+        .price            = to_fixed(price),
+        .quantity         = qty,
+        .side             = side,
+        .type             = type,
+        .display_quantity = 0,
+        .timestamp        = now_ns()
     };
 }
 
@@ -32,7 +49,7 @@ void print_trades(const std::vector<Trade>& trades) {
     for (const auto& t : trades) {
         std::cout << "  TRADE  buy_id=" << t.buy_order_id
                   << "  sell_id=" << t.sell_order_id
-                  << "  price=" << std::fixed << std::setprecision(2) << t.price
+                  << "  price=" << std::fixed << std::setprecision(2) << to_double(t.price)
                   << "  qty=" << t.quantity << "\n";
     }
 }
@@ -44,9 +61,9 @@ void print_book(Engine& engine, const std::string& symbol) {
     auto ask = engine.best_ask(symbol);
     auto spd = engine.spread(symbol);
 
-    std::cout << "  best bid : " << (bid ? std::to_string(*bid) : "empty") << "\n";
-    std::cout << "  best ask : " << (ask ? std::to_string(*ask) : "empty") << "\n";
-    std::cout << "  spread   : " << (spd ? std::to_string(*spd) : "empty") << "\n";
+    std::cout << "  best bid : " << (bid ? std::to_string(to_double(*bid)) : "empty") << "\n";
+    std::cout << "  best ask : " << (ask ? std::to_string(to_double(*ask)) : "empty") << "\n";
+    std::cout << "  spread   : " << (spd ? std::to_string(to_double(*spd)) : "empty") << "\n";
 }
 
 int main() {
@@ -110,6 +127,1073 @@ int main() {
     print_book(engine, "RELIANCE");
     print_book(engine, "AAPL");
 
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 7 — tick ladder book, sweep across levels\n";
+    std::cout << "========================================\n";
+    engine.add_symbol("INFY", InstrumentConfig{.tick_size = to_fixed(0.05), .min_price = to_fixed(1400.00), .max_price = to_fixed(1600.00)});
+    InstrumentId infy = *engine.find_symbol("INFY");
+    engine.submit(infy, make_order(Side::SELL, OrderType::LIMIT, 1500.05, 100));
+    engine.submit(infy, make_order(Side::SELL, OrderType::LIMIT, 1500.10, 100));
+    engine.submit(infy, make_order(Side::BUY,  OrderType::LIMIT, 1499.95, 100));
+    auto t9 = engine.submit(infy, make_order(Side::BUY, OrderType::LIMIT, 1500.10, 150));
+    print_trades(t9);
+    print_book(engine, "INFY");
+    try {
+        engine.submit(infy, make_order(Side::BUY, OrderType::LIMIT, 1700.00, 10));
+        std::cout << "  out-of-band order: ACCEPTED (unexpected)\n";
+    } catch (const std::out_of_range&) {
+        std::cout << "  out-of-band order: REJECTED\n";
+    }
+    std::cout << "  quantity off the tick grid: ask @ 1500.12 = " << engine.book(infy).ask_quantity_at(to_fixed(1500.12))
+              << " (1500.10 holds " << engine.book(infy).ask_quantity_at(to_fixed(1500.10)) << ")"
+              << ", bid @ 1499.97 = " << engine.book(infy).bid_quantity_at(to_fixed(1499.97)) << "\n";
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 8 — sharded engine, two matching threads\n";
+    std::cout << "========================================\n";
+    {
+        ShardedEngine sharded(2);
+        InstrumentId tcs  = sharded.add_symbol("TCS");
+        InstrumentId wipr = sharded.add_symbol("WIPRO");
+        InstrumentId lt   = sharded.add_symbol("LT", InstrumentConfig{.tick_size = to_fixed(1.00), .min_price = to_fixed(90.00), .max_price = to_fixed(110.00)});
+
+        RiskGate      gate;
+        AccountLimits small;
+        small.max_order_quantity = 1000;
+        gate.set_limits(0, AccountLimits{});
+        gate.set_limits(3, small);
+        sharded.set_risk(sharded.shard_of(tcs), &gate);
+        sharded.start();
+        sharded.submit(tcs,  make_order(Side::SELL, OrderType::LIMIT, 3900.00, 100));
+        sharded.submit(wipr, make_order(Side::SELL, OrderType::LIMIT,  450.00, 100));
+        sharded.submit(tcs,  make_order(Side::BUY,  OrderType::LIMIT, 3900.00,  60));
+        sharded.submit(wipr, make_order(Side::BUY,  OrderType::LIMIT,  450.00, 100));
+
+        // off-band order and amend come back as rejects; the shard keeps matching
+        Order off_band = make_order(Side::BUY, OrderType::LIMIT, 200.00, 10);
+        Order resting  = make_order(Side::SELL, OrderType::LIMIT, 100.00, 10);
+        sharded.submit(lt, off_band);
+        sharded.submit(lt, resting);
+        sharded.modify(lt, resting.order_id, to_fixed(150.00), 10);
+        sharded.submit(lt, make_order(Side::BUY, OrderType::LIMIT, 100.00, 10));
+
+        // a risk refusal on the shard's own gate is reported the same way
+        Order oversized = make_order(Side::BUY, OrderType::LIMIT, 3900.00, 5000);
+        oversized.account = 3;
+        sharded.submit(tcs,  oversized);
+        sharded.submit(tcs,  make_order(Side::BUY, OrderType::LIMIT, 3900.00, 40));
+        sharded.stop();
+
+        std::vector<ExecutionReport> reports;
+        sharded.poll([&](const ExecutionReport& r) { reports.push_back(r); });
+        std::stable_sort(reports.begin(), reports.end(), [](const auto& a, const auto& b) {
+            return a.instrument < b.instrument;
+        });
+        for (const auto& r : reports) {
+            std::cout << "  shard " << sharded.shard_of(r.instrument) << "  "
+                      << (r.instrument == tcs ? "TCS  " : r.instrument == wipr ? "WIPRO" : "LT   ");
+            if (r.type == ReportType::REJECT && r.risk != RiskResult::ACCEPTED)
+                std::cout << "  REJECT " << to_string(r.risk) << "\n";
+            else if (r.type == ReportType::REJECT)
+                std::cout << "  REJECT " << (r.order_id == off_band.order_id ? "off-band order" : "off-band amend") << "\n";
+            else
+                print_trades({r.trade});
+        }
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 9 — journal, then replay into a fresh engine\n";
+    std::cout << "========================================\n";
+    {
+        const char* path = "main_test.journal";
+        std::vector<Trade> live_trades, replayed_trades;
+        auto collect = [](std::vector<Trade>& out) {
+            return [&out](const Trade& t) { out.push_back(t); };
+        };
+
+        Engine live;
+        {
+            JournalWriter journal(path);
+            live.set_journal(&journal);
+            live.add_symbol("HDFC", InstrumentConfig{.tick_size = to_fixed(0.05), .min_price = to_fixed(1500.00), .max_price = to_fixed(1700.00)});
+            live.submit("HDFC", make_order(Side::SELL, OrderType::LIMIT, 1600.00, 300), collect(live_trades));
+            live.submit("HDFC", make_order(Side::SELL, OrderType::LIMIT, 1600.05, 200), collect(live_trades));
+            Order resting = make_order(Side::BUY, OrderType::LIMIT, 1599.00, 100);
+            live.submit("HDFC", resting, collect(live_trades));
+            live.submit("HDFC", make_order(Side::BUY, OrderType::MARKET, 0.0, 400), collect(live_trades));
+            live.cancel("HDFC", resting.order_id);
+            live.submit("SBIN", make_order(Side::BUY, OrderType::LIMIT, 800.00, 50), collect(live_trades));
+
+            uint64_t before = journal.records();
+            try {
+                live.submit("HDFC", make_order(Side::BUY, OrderType::LIMIT, 1800.00, 10), collect(live_trades));
+            } catch (const std::out_of_range&) {}
+            std::cout << "  off-band order    : refused, " << (journal.records() == before ? "not journaled" : "JOURNALED") << "\n";
+            live.set_journal(nullptr);
+        }
+
+        Engine recovered;
+        JournalReader reader(path);
+        size_t orders = replay(reader, recovered, collect(replayed_trades));
+
+        bool same = live_trades.size() == replayed_trades.size();
+        for (size_t i = 0; same && i < live_trades.size(); i++) {
+            same = live_trades[i].buy_order_id  == replayed_trades[i].buy_order_id
+                && live_trades[i].sell_order_id == replayed_trades[i].sell_order_id
+                && live_trades[i].price         == replayed_trades[i].price
+                && live_trades[i].quantity      == replayed_trades[i].quantity;
+        }
+        std::cout << "  journaled records : " << reader.size() << "\n";
+        std::cout << "  replayed orders   : " << orders << "\n";
+        std::cout << "  trade stream      : " << (same ? "IDENTICAL" : "DIFFERENT") << "\n";
+        print_trades(replayed_trades);
+        print_book(recovered, "HDFC");
+        print_book(recovered, "SBIN");
+
+        // a record type this build does not know stops the replay
+        {
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            uint32_t unknown = 99;
+            file.seekp(sizeof(JournalHeader) + (reader.size() - 1) * sizeof(JournalRecord));
+            file.write(reinterpret_cast<const char*>(&unknown), sizeof(unknown));
+        }
+        try {
+            Engine strict;
+            replay(JournalReader(path), strict, [](const Trade&) {});
+            std::cout << "  unknown record    : replayed\n";
+        } catch (const std::runtime_error& e) {
+            std::cout << "  unknown record    : " << e.what() << "\n";
+        }
+        std::remove(path);
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 10 — snapshot plus journal tail restores the book\n";
+    std::cout << "========================================\n";
+    {
+        const char* journal_path  = "main_test.journal";
+        const char* snapshot_path = "main_test.snapshot";
+
+        Engine live;
+        {
+            JournalWriter journal(journal_path);
+            live.set_journal(&journal);
+            live.add_symbol("ITC", InstrumentConfig{.tick_size = to_fixed(0.05), .min_price = to_fixed(400.00), .max_price = to_fixed(500.00)});
+            live.submit("ITC", make_order(Side::BUY,  OrderType::LIMIT, 449.95, 100));
+            live.submit("ITC", make_order(Side::BUY,  OrderType::LIMIT, 449.95, 200));
+            live.submit("ITC", make_order(Side::BUY,  OrderType::LIMIT, 449.90, 300));
+            live.submit("ITC", make_order(Side::SELL, OrderType::LIMIT, 450.10, 400));
+            save_snapshot_async(live, snapshot_path).get();
+
+            // the tail: only these are replayed after the snapshot loads
+            live.submit("ITC", make_order(Side::SELL, OrderType::LIMIT, 449.95, 150));
+            live.submit("ITC", make_order(Side::BUY,  OrderType::LIMIT, 450.00,  50));
+            live.set_journal(nullptr);
+        }
+
+        Engine        recovered;
+        uint64_t      sequence = load_snapshot(snapshot_path, recovered);
+        JournalReader reader(journal_path);
+        size_t        tail     = replay(reader, recovered, [](const Trade&) {}, sequence);
+        std::cout << "  resume sequence : " << sequence << "\n";
+        std::cout << "  tail orders     : " << tail << "\n";
+
+        bool same = true;
+        for (Price price : {to_fixed(449.90), to_fixed(449.95), to_fixed(450.00), to_fixed(450.10)}) {
+            same = same && live.book(0).bid_quantity_at(price) == recovered.book(0).bid_quantity_at(price)
+                        && live.book(0).ask_quantity_at(price) == recovered.book(0).ask_quantity_at(price);
+        }
+        std::cout << "  book state      : " << (same ? "IDENTICAL" : "DIFFERENT") << "\n";
+        print_book(recovered, "ITC");
+        std::remove(journal_path);
+        std::remove(snapshot_path);
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 11 — conflated L2 updates and top-N depth\n";
+    std::cout << "========================================\n";
+    {
+        Engine md;
+        InstrumentId lt = md.intern("LT");
+        ConflatingPublisher publisher;
+        md.set_listener(lt, &publisher);
+
+        md.submit(lt, make_order(Side::BUY,  OrderType::LIMIT, 3500.00, 100));
+        md.submit(lt, make_order(Side::BUY,  OrderType::LIMIT, 3500.00, 200));
+        md.submit(lt, make_order(Side::BUY,  OrderType::LIMIT, 3499.00, 300));
+        md.submit(lt, make_order(Side::SELL, OrderType::LIMIT, 3501.00, 400));
+        md.submit(lt, make_order(Side::SELL, OrderType::LIMIT, 3500.00, 150));  // fills at 3500.00
+
+        std::cout << "  6 level changes conflated into " << publisher.pending() << " updates\n";
+        publisher.flush([](const LevelUpdate& u) {
+            std::cout << "  L2  " << (u.side == Side::BUY ? "BID " : "ASK ")
+                      << std::fixed << std::setprecision(2) << to_double(u.price) << "  qty=" << u.quantity << "\n";
+        });
+
+        for (const DepthLevel& level : md.depth(lt, Side::BUY, 5))
+            std::cout << "  depth BID " << to_double(level.price) << "  qty=" << level.quantity << "\n";
+        md.set_listener(lt, nullptr);
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 12 — L3 order events and zero-copy depth walk\n";
+    std::cout << "========================================\n";
+    {
+        Engine md;
+        InstrumentId axis = md.intern("AXIS");
+        OrderEventQueue feed;
+        md.set_listener(axis, &feed);
+
+        Order first  = make_order(Side::BUY, OrderType::LIMIT, 1100.00, 100);
+        Order second = make_order(Side::BUY, OrderType::LIMIT, 1100.00, 200);
+        md.submit(axis, first);
+        md.submit(axis, second);
+        md.submit(axis, make_order(Side::BUY,  OrderType::LIMIT, 1099.50, 300));
+        md.submit(axis, make_order(Side::SELL, OrderType::LIMIT, 1100.00,  40));
+        md.cancel(axis, second.order_id);
+
+        const char* names[] = {"ADD", "MODIFY", "EXECUTE", "DELETE"};
+        OrderEvent  event;
+        while (feed.try_pop(event)) {
+            std::cout << "  L3  " << std::left << std::setw(8) << names[(int)event.type] << std::right
+                      << "id=" << event.order_id << "  pos=" << event.position
+                      << "  delta=" << event.delta << "  left=" << event.quantity
+                      << "  @ " << std::fixed << std::setprecision(2) << to_double(event.price) << "\n";
+        }
+
+        md.book(axis).for_each_level(Side::BUY, [](Price price, const PriceLevel& level) {
+            std::cout << "  level " << to_double(price) << "  orders=" << level.order_count() << " :";
+            for (const Order& o : level) std::cout << " #" << o.order_id << "(" << o.quantity << ")";
+            std::cout << "\n";
+            return true;
+        });
+        md.set_listener(axis, nullptr);
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 13 — batch submit across symbols\n";
+    std::cout << "========================================\n";
+    {
+        Engine batch;
+        InstrumentId infy = batch.intern("INFY");
+        batch.add_symbol("WIPRO", InstrumentConfig{.tick_size = to_fixed(0.05), .min_price = to_fixed(400.0), .max_price = to_fixed(500.0)});
+        InstrumentId wipro = *batch.find_symbol("WIPRO");
+        batch.submit(infy,  make_order(Side::SELL, OrderType::LIMIT, 1500.00, 100));
+        batch.submit(wipro, make_order(Side::SELL, OrderType::LIMIT,  450.00, 200));
+
+        OrderMessage msgs[] = {
+            {infy,  make_order(Side::BUY,  OrderType::LIMIT, 1500.00,  60)},
+            {wipro, make_order(Side::BUY,  OrderType::LIMIT,  450.00, 250)},
+            {infy,  make_order(Side::BUY,  OrderType::LIMIT, 1500.00,  60)},
+            {wipro, make_order(Side::BUY,  OrderType::LIMIT,  520.00,  10)},
+        };
+        BatchResult result;
+        batch.submit_batch(msgs, 4, result);
+
+        for (size_t i = 0; i < 4; i++) {
+            const BatchFill& fill = result.fills[i];
+            std::cout << "  msg " << i << " (" << batch.symbol_name(msgs[i].instrument) << ")";
+            if (fill.rejected) { std::cout << "  rejected\n"; continue; }
+            std::cout << "  fills=" << fill.count;
+            for (uint32_t k = fill.begin; k < fill.begin + fill.count; k++)
+                std::cout << "  [" << result.trades[k].quantity << " @ "
+                          << std::fixed << std::setprecision(2) << to_double(result.trades[k].price) << "]";
+            std::cout << "\n";
+        }
+        std::cout << "  INFY  best bid: " << to_double(batch.best_bid(infy).value_or(0))
+                  << "  WIPRO best bid: " << to_double(batch.best_bid(wipro).value_or(0)) << "\n";
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 14 — amend in place: priority kept on a cut, lost on a move\n";
+    std::cout << "========================================\n";
+    {
+        Engine amend;
+        amend.add_symbol("HDFC", InstrumentConfig{.tick_size = to_fixed(0.05), .min_price = to_fixed(1500.0), .max_price = to_fixed(1700.0)});
+        InstrumentId hdfc = *amend.find_symbol("HDFC");
+        OrderEventQueue feed;
+        amend.set_listener(hdfc, &feed);
+
+        Order a = make_order(Side::BUY, OrderType::LIMIT, 1600.00, 100);
+        Order b = make_order(Side::BUY, OrderType::LIMIT, 1600.00, 100);
+        Order c = make_order(Side::BUY, OrderType::LIMIT, 1600.00, 100);
+        for (const Order& o : {a, b, c}) amend.submit(hdfc, o);
+        amend.submit(hdfc, make_order(Side::SELL, OrderType::LIMIT, 1600.50, 50));
+
+        auto on_trade = [](const Trade& t) {
+            std::cout << "  TRADE  buy=" << t.buy_order_id << "  sell=" << t.sell_order_id
+                      << "  qty=" << t.quantity << "  @ " << std::fixed << std::setprecision(2) << to_double(t.price) << "\n";
+        };
+        amend.modify(hdfc, a.order_id, to_fixed(1600.00),  60, on_trade);  // cut: stays first
+        amend.modify(hdfc, b.order_id, to_fixed(1600.00), 150, on_trade);  // increase: back of the queue
+        amend.modify(hdfc, c.order_id, to_fixed(1600.50),  80, on_trade);  // reprice through the ask
+        bool missing = amend.modify(hdfc, 999999, to_fixed(1600.00), 10, on_trade);
+
+        const char* names[] = {"ADD", "MODIFY", "EXECUTE", "DELETE"};
+        OrderEvent  event;
+        while (feed.try_pop(event)) {
+            if (event.order_id != a.order_id && event.order_id != b.order_id && event.order_id != c.order_id) continue;
+            std::cout << "  L3  " << std::left << std::setw(8) << names[(int)event.type] << std::right
+                      << "id=" << event.order_id << "  pos=" << event.position
+                      << "  delta=" << event.delta << "  left=" << event.quantity
+                      << "  @ " << std::fixed << std::setprecision(2) << to_double(event.price) << "\n";
+        }
+
+        amend.book(hdfc).for_each_level(Side::BUY, [](Price price, const PriceLevel& level) {
+            std::cout << "  level " << to_double(price) << "  qty=" << level.total_quantity() << " :";
+            for (const Order& o : level) std::cout << " #" << o.order_id << "(" << o.quantity << ")";
+            std::cout << "\n";
+            return true;
+        });
+        std::cout << "  best ask after reprice: " << (amend.best_ask(hdfc) ? "present" : "none")
+                  << "  unknown id amended: " << (missing ? "yes" : "no") << "\n";
+        amend.set_listener(hdfc, nullptr);
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 15 — IOC, FOK, post-only and iceberg\n";
+    std::cout << "========================================\n";
+    {
+        Engine tif;
+        tif.add_symbol("SBIN", InstrumentConfig{.tick_size = to_fixed(0.05), .min_price = to_fixed(700.0), .max_price = to_fixed(900.0)});
+        InstrumentId sbin = *tif.find_symbol("SBIN");
+        const OrderBook& book = tif.book(sbin);
+
+        auto on_trade = [](const Trade& t) {
+            std::cout << "    TRADE  qty=" << t.quantity << "  @ " << std::fixed << std::setprecision(2) << to_double(t.price) << "\n";
+        };
+        auto with = [](Order o, TimeInForce t, bool post_only = false, uint32_t peak = 0) {
+            o.tif = t;
+            o.post_only = post_only;
+            o.display_quantity = peak;
+            return o;
+        };
+
+        tif.submit(sbin, make_order(Side::SELL, OrderType::LIMIT, 800.00, 10));
+        tif.submit(sbin, make_order(Side::SELL, OrderType::LIMIT, 800.50, 20));
+        tif.submit(sbin, with(make_order(Side::SELL, OrderType::LIMIT, 801.00, 100), TimeInForce::GTC, false, 25));
+        std::cout << "  iceberg rests: shown " << book.ask_quantity_at(to_fixed(801.00)) << " of 100\n";
+
+        std::cout << "  IOC buy 50 @ 800.50:\n";
+        tif.submit(sbin, with(make_order(Side::BUY, OrderType::LIMIT, 800.50, 50), TimeInForce::IOC), on_trade);
+        std::cout << "    remainder rested: " << (tif.best_bid(sbin) ? "yes" : "no") << "\n";
+
+        std::cout << "  FOK buy 200 @ 801.00 (only 100 available):\n";
+        size_t before = book.order_count();
+        tif.submit(sbin, with(make_order(Side::BUY, OrderType::LIMIT, 801.00, 200), TimeInForce::FOK), on_trade);
+        std::cout << "    untouched: " << (book.order_count() == before && book.ask_quantity_at(to_fixed(801.00)) == 25 ? "yes" : "no") << "\n";
+
+        std::cout << "  FOK buy 60 @ 801.00 (iceberg replenishes):\n";
+        tif.submit(sbin, with(make_order(Side::BUY, OrderType::LIMIT, 801.00, 60), TimeInForce::FOK), on_trade);
+        std::cout << "    shown at 801.00: " << book.ask_quantity_at(to_fixed(801.00)) << "\n";
+
+        tif.submit(sbin, with(make_order(Side::BUY, OrderType::LIMIT, 801.00, 10), TimeInForce::GTC, true), on_trade);
+        Order maker = with(make_order(Side::BUY, OrderType::LIMIT, 800.90, 10), TimeInForce::GTC, true);
+        tif.submit(sbin, maker, on_trade);
+        std::cout << "  post-only: crossing one dropped, passive one rests at "
+                  << std::fixed << std::setprecision(2) << to_double(tif.best_bid(sbin).value_or(0))
+                  << "  (bid qty " << book.bid_quantity_at(to_fixed(801.00)) << " @ 801.00)\n";
+
+        bool crossing = tif.modify(sbin, maker.order_id, to_fixed(801.00), 10, on_trade);
+        bool passive  = tif.modify(sbin, maker.order_id, to_fixed(800.95), 10, on_trade);
+        std::cout << "  post-only amend to 801.00 " << (crossing ? "applied" : "refused")
+                  << ", to 800.95 " << (passive ? "applied" : "refused")
+                  << "  (best bid " << to_double(tif.best_bid(sbin).value_or(0))
+                  << ", ask qty " << book.ask_quantity_at(to_fixed(801.00)) << " @ 801.00)\n";
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 16 — pre-trade risk gate\n";
+    std::cout << "========================================\n";
+    {
+        Engine   guarded;
+        RiskGate gate;
+        guarded.set_risk(&gate);
+        InstrumentId itc = guarded.intern("ITC");
+
+        AccountLimits tight;
+        tight.max_order_quantity = 1000;
+        tight.price_collar       = 0.05;
+        tight.max_position       = 500;
+        tight.max_messages       = 4;
+        gate.set_limits(7, tight);
+        gate.set_limits(8, AccountLimits{});
+
+        auto from = [](uint32_t account, Order o) { o.account = account; return o; };
+        auto none = [](const Trade&) {};
+        auto show = [&](const char* what, RiskResult verdict) {
+            std::cout << "  " << std::left << std::setw(28) << what << std::right << to_string(verdict) << "\n";
+        };
+
+        show("acct 8 sell 1000 @ 400.00", guarded.submit(itc, from(8, make_order(Side::SELL, OrderType::LIMIT, 400.00, 1000)), none));
+        show("acct 7 buy 2000 @ 400.00",  guarded.submit(itc, from(7, make_order(Side::BUY,  OrderType::LIMIT, 400.00, 2000)), none));
+        show("acct 7 buy 100 @ 425.00",   guarded.submit(itc, from(7, make_order(Side::BUY,  OrderType::LIMIT, 425.00,  100)), none));
+        show("acct 7 buy 400 @ 400.00",   guarded.submit(itc, from(7, make_order(Side::BUY,  OrderType::LIMIT, 400.00,  400)), none));
+        show("acct 7 buy 200 @ 400.00",   guarded.submit(itc, from(7, make_order(Side::BUY,  OrderType::LIMIT, 400.00,  200)), none));
+        show("acct 7 sell 100 @ 401.00",  guarded.submit(itc, from(7, make_order(Side::SELL, OrderType::LIMIT, 401.00,  100)), none));
+        show("acct 99 buy 10 @ 399.00",   guarded.submit(itc, from(99, make_order(Side::BUY, OrderType::LIMIT, 399.00,   10)), none));
+
+        std::cout << "  acct 7 position " << gate.account(7).position
+                  << "  acct 8 position " << gate.account(8).position
+                  << "  ask left " << guarded.book(itc).ask_quantity_at(to_fixed(400.00)) << "\n";
+
+        // amends are checked against the order they target, under its account
+        AccountLimits amender = tight;
+        amender.max_position = 150;
+        amender.max_messages = 5;
+        gate.set_limits(9, amender);
+
+        Order resting = from(9, make_order(Side::BUY, OrderType::LIMIT, 390.00, 100));
+        auto amend = [&](double price, uint32_t qty) {
+            Order o    = make_order(Side::BUY, OrderType::MODIFY, price, qty);
+            o.order_id = resting.order_id;
+            return guarded.submit(itc, o, none);
+        };
+        show("acct 9 buy 100 @ 390.00",   guarded.submit(itc, resting, none));
+        show("  amend to 2000 @ 390.00",  amend(390.00, 2000));
+        show("  amend to 300 @ 390.00",   amend(390.00,  300));
+        show("  amend to 100 @ 425.00",   amend(425.00,  100));
+        show("  amend to 50 @ 395.00",    amend(395.00,   50));
+        bool sixth = guarded.modify(itc, resting.order_id, to_fixed(395.00), 60, none);
+        std::cout << "  6th message modify() -> " << (sixth ? "applied" : "refused")
+                  << "  bid at 395.00 " << guarded.book(itc).bid_quantity_at(to_fixed(395.00)) << "\n";
+
+        // resting orders count toward the limit until they fill or leave
+        AccountLimits quoter;
+        quoter.max_position = 100;
+        gate.set_limits(10, quoter);
+        Order first = from(10, make_order(Side::BUY, OrderType::LIMIT, 380.00, 100));
+        show("acct 10 buy 100 @ 380.00",  guarded.submit(itc, first, none));
+        show("acct 10 buy 100 @ 380.00",  guarded.submit(itc, from(10, make_order(Side::BUY, OrderType::LIMIT, 380.00, 100)), none));
+        guarded.modify(itc, first.order_id, to_fixed(380.00), 60, none);
+        show("  first cut to 60; buy 40",  guarded.submit(itc, from(10, make_order(Side::BUY, OrderType::LIMIT, 380.00, 40)), none));
+        show("  buy 1 @ 380.00",           guarded.submit(itc, from(10, make_order(Side::BUY, OrderType::LIMIT, 380.00, 1)), none));
+        guarded.cancel(itc, first.order_id);
+        show("  first cancelled; buy 30",  guarded.submit(itc, from(10, make_order(Side::BUY, OrderType::LIMIT, 380.00, 30)), none));
+        Order ioc = from(10, make_order(Side::BUY, OrderType::LIMIT, 380.00, 30));
+        ioc.tif   = TimeInForce::IOC;
+        show("  IOC buy 30, no fill",     guarded.submit(itc, ioc, none));
+        std::cout << "  acct 10 open buys " << gate.account(10).open_buys
+                  << "  acct 8 open sells " << gate.account(8).open_sells << "\n";
+        guarded.mass_cancel(itc, CancelFilter::all());
+        std::cout << "  after mass cancel: acct 10 open buys " << gate.account(10).open_buys
+                  << "  acct 8 open sells " << gate.account(8).open_sells << "\n";
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 17 — in-engine latency histograms and counters\n";
+    std::cout << "========================================\n";
+    {
+        Engine        timed;
+        EngineMetrics metrics;
+        timed.set_metrics(&metrics);
+
+        std::vector<uint64_t> resting;
+        for (int i = 0; i < 200; i++) {
+            Order o = make_order(Side::SELL, OrderType::LIMIT, 250.00 + (i % 10) * 0.05, 10);
+            resting.push_back(o.order_id);
+            timed.submit("TCS", o);
+        }
+        for (int i = 0; i < 20; i++)
+            timed.submit("TCS", make_order(Side::BUY, OrderType::LIMIT, 250.45, 35));
+        for (size_t i = 100; i < 200; i += 2) timed.cancel("TCS", resting[i]);
+
+        MetricsReport report = metrics.report();
+        report.print(std::cout);
+        std::cout << "  submits=" << report.stages[(size_t)Stage::SUBMIT].total
+                  << "  cancels=" << report.stages[(size_t)Stage::CANCEL].total
+                  << "  fills=" << report.fills_per_order.sum << "\n";
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 18 — seeded synthetic order flow\n";
+    std::cout << "========================================\n";
+    {
+        FlowProfile profile;
+        profile.orders  = 20000;
+        profile.symbols = 8;
+        profile.seed    = 42;
+
+        const char* paths[] = {"/tmp/orderbook_flow_a.flow", "/tmp/orderbook_flow_b.flow"};
+        uint64_t    sums[2];
+        for (int run = 0; run < 2; run++) {
+            generate_flow(profile, paths[run]);
+            JournalReader flow(paths[run]);
+            Engine        engine;
+            uint64_t      sum = 0;
+            replay(flow, engine, [&](const Trade& t) { sum = sum * 31 + t.buy_order_id * 7 + t.sell_order_id + t.quantity; });
+            sums[run] = sum;
+            std::remove(paths[run]);
+        }
+        std::cout << "  instruments=" << profile.symbols << "  messages=" << profile.orders
+                  << "  same seed, same fills: " << (sums[0] == sums[1] ? "yes" : "NO") << "\n";
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 19 — sparse ladder, best level found across gaps\n";
+    std::cout << "========================================\n";
+    {
+        Engine thin;
+        thin.add_symbol("ONGC", InstrumentConfig{.tick_size = to_fixed(0.01), .min_price = to_fixed(100.0), .max_price = to_fixed(300.0)});
+        InstrumentId ongc = *thin.find_symbol("ONGC");
+
+        // asks 5000 ticks apart with a bid far below: every step crosses a wide gap
+        Order lone = make_order(Side::SELL, OrderType::LIMIT, 150.00, 100);
+        thin.submit(ongc, lone);
+        for (double price : {200.00, 250.00, 299.99})
+            thin.submit(ongc, make_order(Side::SELL, OrderType::LIMIT, price, 100));
+        thin.submit(ongc, make_order(Side::BUY, OrderType::LIMIT, 100.00, 100));
+
+        thin.cancel(ongc, lone.order_id);
+        std::cout << "  after cancel at 150.00, best ask " << to_double(*thin.best_ask(ongc)) << "\n";
+
+        auto sweep = thin.submit(ongc, make_order(Side::BUY, OrderType::MARKET, 0.0, 150));
+        std::cout << "  market buy 150 filled " << sweep.size() << " levels, best ask now "
+                  << to_double(*thin.best_ask(ongc)) << "\n";
+
+        for (Side side : {Side::SELL, Side::BUY})
+            for (const DepthLevel& level : thin.depth(ongc, side, 3))
+                std::cout << "  depth " << (side == Side::BUY ? "BID " : "ASK ") << to_double(level.price)
+                          << "  qty=" << level.quantity << "\n";
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 20 — socket gateway, two sessions over a Unix socket\n";
+    std::cout << "========================================\n";
+    {
+        Engine venue;
+        venue.add_symbol("TCS", InstrumentConfig{.tick_size = to_fixed(0.05), .min_price = to_fixed(3000.0), .max_price = to_fixed(4000.0)});
+        InstrumentId tcs = *venue.find_symbol("TCS");
+
+        GatewayOptions options;
+        options.unix_path = "/tmp/orderbook_gateway_test." + std::to_string(getpid()) + ".sock";
+        Gateway gateway(venue, options);
+        gateway.start();
+
+        GatewayClient maker(options.unix_path), taker(options.unix_path);
+        auto on_ack = [](const char* who) {
+            return [who](const AckMsg& ack) {
+                std::cout << "  " << who << " ACK   id=" << ack.client_order_id << "  " << to_string(ack.status) << "\n";
+            };
+        };
+        auto on_fill = [](const char* who) {
+            return [who](const FillMsg& fill) {
+                std::cout << "  " << who << " FILL  id=" << fill.client_order_id << "  " << fill.quantity
+                          << " @ " << to_double(fill.price) << "\n";
+            };
+        };
+        // one ACK closes each request; fills for it arrive first
+        auto await_acks = [&](GatewayClient& client, const char* who, int count) {
+            while (count > 0)
+                client.receive([&](const AckMsg& ack) { on_ack(who)(ack); --count; }, on_fill(who));
+        };
+
+        // both sessions use client id 1; the gateway keeps them apart
+        maker.new_order(tcs, 1, make_order(Side::SELL, OrderType::LIMIT, 3500.00, 100), now_ns());
+        maker.flush();
+        await_acks(maker, "maker", 1);
+
+        taker.new_order(tcs, 1, make_order(Side::BUY, OrderType::LIMIT, 3500.00, 60), now_ns());
+        taker.new_order(tcs, 2, make_order(Side::BUY, OrderType::LIMIT, 3500.02, 10), now_ns());
+        taker.flush();
+        await_acks(taker, "taker", 2);
+        maker.receive(on_ack("maker"), on_fill("maker"));
+
+        maker.cancel(tcs, 1, now_ns());
+        maker.cancel(tcs, 1, now_ns());
+        maker.flush();
+        await_acks(maker, "maker", 2);
+
+        gateway.stop();
+        std::cout << "  book after stop: " << (venue.best_ask(tcs) ? "asks left" : "no asks") << "\n";
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 21 — shared-memory order entry from another process\n";
+    std::cout << "========================================\n";
+    {
+        Engine venue;
+        venue.add_symbol("HDFC", InstrumentConfig{.tick_size = to_fixed(0.05), .min_price = to_fixed(1000.0), .max_price = to_fixed(2000.0)});
+        InstrumentId hdfc = *venue.find_symbol("HDFC");
+
+        const std::string name = "/orderbook_test." + std::to_string(getpid());
+        ShmOptions options;
+        options.order_slots = 64;
+        options.event_slots = 64;
+        ShmGateway gateway(venue, name, options);
+        ShmClient  reader(name);
+
+        // the child fills the order ring and exits before the matching thread starts
+        pid_t child = fork();
+        if (child == 0) {
+            ShmClient producer(name);
+            producer.submit(hdfc, make_order(Side::SELL, OrderType::LIMIT, 1500.00, 100));
+            producer.submit(hdfc, make_order(Side::BUY, OrderType::LIMIT, 1500.00, 60));
+            producer.submit(hdfc, make_order(Side::BUY, OrderType::LIMIT, 1500.01, 10));
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(child, &status, 0);
+        std::cout << "  producer process exited " << WEXITSTATUS(status) << ", "
+                  << gateway.processed() << " orders processed so far\n";
+
+        gateway.start();
+        size_t events = 0;
+        while (events < 4) {
+            events += reader.poll([](const ShmEvent& e) {
+                if (e.type == ShmEventType::TRADE)
+                    std::cout << "  TRADE   " << e.trade.quantity << " @ " << to_double(e.trade.price) << "\n";
+                else if (e.type == ShmEventType::LEVEL)
+                    std::cout << "  LEVEL   " << (e.level.side == Side::BUY ? "bid " : "ask ")
+                              << to_double(e.level.price) << "  qty=" << e.level.quantity << "\n";
+                else
+                    std::cout << "  REJECT  order_id=" << e.order_id << " (off tick)\n";
+            }, true);
+        }
+        gateway.stop();
+        std::cout << "  events=" << events << "  lost=" << reader.lost() << "  processed=" << gateway.processed() << "\n";
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 22 — order-id index, reclamation and a flat footprint\n";
+    std::cout << "========================================\n";
+    {
+        // a small key space keeps probe runs long and wrapping, so erase has to shift them
+        OrderIndex index;
+        std::unordered_map<uint64_t, OrderNode*> reference;
+        std::vector<OrderNode> nodes(512);
+        std::mt19937_64 rng(22);
+        size_t mismatches = 0;
+        for (int op = 0; op < 200000; op++) {
+            uint64_t id = (rng() % 4 << 40) | (rng() % 512);
+            if (rng() % 2) {
+                index.insert(id, &nodes[id & 511]);
+                reference[id] = &nodes[id & 511];
+            } else {
+                mismatches += index.erase(id) != (reference.erase(id) == 1);
+            }
+            uint64_t probe = (rng() % 4 << 40) | (rng() % 512);
+            auto     loc   = reference.find(probe);
+            mismatches += index.find(probe) != (loc == reference.end() ? nullptr : loc->second);
+        }
+        std::cout << "  200000 random inserts/erases against std::unordered_map: mismatches=" << mismatches
+                  << "  size=" << index.size() << "/" << reference.size() << "  slots=" << index.capacity() << "\n";
+
+        // a session of adds, sweeps, amends and cancels at a steady resting count
+        Engine day;
+        day.add_symbol("WIPRO", InstrumentConfig{.tick_size = to_fixed(0.05), .min_price = to_fixed(400.0), .max_price = to_fixed(600.0)});
+        InstrumentId wipro = *day.find_symbol("WIPRO");
+        day.reserve(wipro, 1000);
+
+        std::deque<uint64_t> live;
+        MemoryUsage          first;
+        auto on_trade = [](const Trade&) {};
+        for (int hour = 1; hour <= 50; hour++) {
+            for (int i = 0; i < 1000; i++) {
+                Side   side  = (i % 2 == 0) ? Side::BUY : Side::SELL;
+                double price = (side == Side::BUY ? 495.00 - (double)(rng() % 40) * 0.05
+                                                  : 500.00 + (double)(rng() % 40) * 0.05);
+                Order  o     = make_order(side, OrderType::LIMIT, price, 100);
+                day.submit(wipro, o, on_trade);
+                live.push_back(o.order_id);
+            }
+            for (int i = 0; i < 100; i++) {
+                day.submit(wipro, make_order(Side::BUY, OrderType::MARKET, 0.0, 250), on_trade);
+                day.submit(wipro, make_order(Side::SELL, OrderType::MARKET, 0.0, 250), on_trade);
+            }
+            for (int i = 0; i < 200; i++)
+                day.modify(wipro, live[rng() % live.size()], to_fixed(495.00), 50, on_trade);
+            // the oldest hour goes: filled ones are already gone from the index
+            while (live.size() > 1000) {
+                day.cancel(wipro, live.front());
+                live.pop_front();
+            }
+            if (hour == 1) first = day.memory();
+        }
+
+        MemoryUsage last    = day.memory();
+        size_t      resting = 0;
+        for (Side side : {Side::BUY, Side::SELL})
+            day.book(wipro).for_each_order(side, [&](Price, const Order&) { ++resting; });
+
+        std::cout << std::setprecision(1);
+        for (const auto& [label, usage] : {std::pair{"hour  1", first}, std::pair{"hour 50", last}})
+            std::cout << "  " << label << ": resting=" << usage.orders << "  bytes=" << usage.total()
+                      << " (nodes " << usage.node_bytes << ", index " << usage.index_bytes << ", levels "
+                      << usage.level_bytes << ")  " << usage.bytes_per_order() << " bytes/order\n";
+        std::cout << std::setprecision(2);
+        std::cout << "  footprint flat across the session: " << (first.total() == last.total() ? "yes" : "no") << "\n";
+        std::cout << "  index entries == resting orders: " << (day.book(wipro).order_count() == resting ? "yes" : "no")
+                  << " (" << resting << ")\n";
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 23 — mass cancel by range, owner, side and on disconnect\n";
+    std::cout << "========================================\n";
+    {
+        const char* path = "main_test_mass.journal";
+        auto owned = [](uint32_t owner) { return ((uint64_t)owner << OWNER_SHIFT) | next_id(); };
+
+        // counts what market data sees: one DELETE per order, one update per level
+        struct Tally : BookListener {
+            size_t deletes = 0, levels = 0;
+            void on_level(const LevelUpdate&) override { ++levels; }
+            void on_order(const OrderEvent& e) override { deletes += e.type == OrderEventType::DELETE; }
+        } tally;
+
+        Engine desk;
+        JournalWriter journal(path);
+        desk.set_journal(&journal);
+        desk.add_symbol("HDFC", InstrumentConfig{.tick_size = to_fixed(0.05), .min_price = to_fixed(1500.00), .max_price = to_fixed(1700.00)});
+        InstrumentId hdfc = *desk.find_symbol("HDFC");
+        InstrumentId sbin = desk.intern("SBIN");  // MAP book
+
+        // owners 1 and 2 quote five levels a side on HDFC, owner 2 also on SBIN
+        for (int level = 0; level < 5; level++) {
+            for (uint32_t owner : {1u, 2u, 1u}) {
+                Order bid    = make_order(Side::BUY, OrderType::LIMIT, 1595.00 - level, 100);
+                bid.order_id = owned(owner);
+                Order ask    = make_order(Side::SELL, OrderType::LIMIT, 1600.00 + level, 100);
+                ask.order_id = owned(owner);
+                desk.submit(hdfc, bid);
+                desk.submit(hdfc, ask);
+            }
+            Order quote    = make_order(Side::BUY, OrderType::LIMIT, 800.00 - level, 50);
+            quote.order_id = owned(2);
+            desk.submit(sbin, quote);
+        }
+        auto print_report = [](const char* what, const MassCancelReport& r) {
+            std::cout << "  " << std::left << std::setw(30) << what << std::right << "orders=" << r.orders
+                      << "  qty=" << r.quantity << "  levels=" << r.levels << "\n";
+        };
+
+        print_report("bids 1591.50 - 1593.00", desk.mass_cancel(hdfc, CancelFilter::range(Side::BUY, to_fixed(1591.50), to_fixed(1593.00))));
+        std::cout << "  HDFC bids left:";
+        for (const DepthLevel& level : desk.depth(hdfc, Side::BUY, 5))
+            std::cout << "  " << to_double(level.price) << "x" << level.quantity;
+        std::cout << "\n";
+
+        desk.set_listener(hdfc, &tally);
+        print_report("owner 2, every book", desk.mass_cancel(CancelFilter::owned_by(2)));
+        desk.set_listener(hdfc, nullptr);
+        std::cout << "  HDFC listener: " << tally.deletes << " DELETEs, " << tally.levels << " level updates\n";
+        std::cout << "  SBIN orders left: " << desk.book(sbin).order_count()
+                  << "  HDFC ask 1600.00 qty=" << desk.book(hdfc).ask_quantity_at(to_fixed(1600.00)) << "\n";
+
+        print_report("all asks", desk.mass_cancel(hdfc, CancelFilter::side(Side::SELL)));
+        std::cout << "  HDFC best ask: " << (desk.best_ask(hdfc) ? "present" : "empty")
+                  << "  resting=" << desk.book(hdfc).order_count() << "\n";
+        desk.set_journal(nullptr);
+        journal.flush();
+
+        Engine        recovered;
+        JournalReader reader(path);
+        replay(reader, recovered, [](const Trade&) {});
+        InstrumentId  again = *recovered.find_symbol("HDFC");
+        std::cout << "  replayed HDFC: resting=" << recovered.book(again).order_count() << "  best bid "
+                  << to_double(*recovered.best_bid(again)) << "  (live " << to_double(*desk.best_bid(hdfc)) << ")\n";
+        std::remove(path);
+
+        // 20k quotes from one owner, pulled in one call
+        Engine kill;
+        kill.add_symbol("NIFTY", InstrumentConfig{.tick_size = to_fixed(0.05), .min_price = to_fixed(20000.00), .max_price = to_fixed(24000.00)});
+        InstrumentId nifty = *kill.find_symbol("NIFTY");
+        kill.reserve(nifty, 20000);
+        for (int i = 0; i < 20000; i++) {
+            Side  side  = (i % 2 == 0) ? Side::BUY : Side::SELL;
+            Order quote = make_order(side, OrderType::LIMIT, side == Side::BUY ? 21999.95 - (i % 500) * 0.05
+                                                                                : 22000.00 + (i % 500) * 0.05, 10);
+            quote.order_id = owned(7);
+            kill.submit(nifty, quote);
+        }
+        uint64_t         t0     = now_ns();
+        MassCancelReport pulled = kill.mass_cancel(CancelFilter::owned_by(7));
+        uint64_t         micros = (now_ns() - t0) / 1000;
+        std::cout << "  kill switch: " << pulled.orders << " quotes on " << pulled.levels << " levels in "
+                  << micros << " us, book empty: " << (kill.book(nifty).order_count() == 0 ? "yes" : "no") << "\n";
+
+        // cancel-on-disconnect through the gateway
+        Engine venue;
+        venue.add_symbol("TCS", InstrumentConfig{.tick_size = to_fixed(0.05), .min_price = to_fixed(3000.0), .max_price = to_fixed(4000.0)});
+        InstrumentId tcs = *venue.find_symbol("TCS");
+
+        GatewayOptions options;
+        options.unix_path            = "/tmp/orderbook_cod_test." + std::to_string(getpid()) + ".sock";
+        options.cancel_on_disconnect = true;
+        Gateway gateway(venue, options);
+        gateway.start();
+        {
+            GatewayClient quoter(options.unix_path);
+            for (uint64_t id = 1; id <= 3; id++)
+                quoter.new_order(tcs, id, make_order(Side::BUY, OrderType::LIMIT, 3500.00 - (double)id, 10), now_ns());
+            quoter.flush();
+            for (int acks = 0; acks < 3;)
+                quoter.receive([&](const AckMsg&) { ++acks; }, [](const FillMsg&) {});
+        }  // connection closes here
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        gateway.stop();
+        std::cout << "  quoter disconnected, TCS resting=" << venue.book(tcs).order_count() << "\n";
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 24 — stop and stop-limit orders, elections and cascades\n";
+    std::cout << "========================================\n";
+    {
+        const char* path          = "main_test_stops.journal";
+        const char* snapshot_path = "main_test_stops.snapshot";
+
+        Engine        live;
+        JournalWriter journal(path);
+        live.set_journal(&journal);
+        live.add_symbol("INFY", InstrumentConfig{.tick_size = to_fixed(0.05), .min_price = to_fixed(1000.00), .max_price = to_fixed(2000.00)});
+        InstrumentId infy = *live.find_symbol("INFY");
+
+        for (double price : {1501.00, 1502.00, 1503.00})
+            live.submit(infy, make_order(Side::SELL, OrderType::LIMIT, price, 100));
+        for (double price : {1499.00, 1498.00, 1497.00, 1496.00})
+            live.submit(infy, make_order(Side::BUY, OrderType::LIMIT, price, 100));
+
+        auto stop = [](Side side, OrderType type, double trigger, double limit, uint64_t qty) {
+            Order order      = make_order(side, type, limit, (uint32_t)qty);
+            order.stop_price = to_fixed(trigger);
+            return order;
+        };
+        live.submit(infy, stop(Side::BUY,  OrderType::STOP,       1501.00, 0,       150));
+        live.submit(infy, stop(Side::BUY,  OrderType::STOP_LIMIT, 1501.00, 1502.00,  50));
+        live.submit(infy, stop(Side::BUY,  OrderType::STOP,       1503.00, 0,        10));
+        live.submit(infy, stop(Side::SELL, OrderType::STOP_LIMIT, 1498.00, 1497.00, 150));
+        live.submit(infy, stop(Side::SELL, OrderType::STOP,       1497.00, 0,       120));
+        std::cout << "  waiting: " << live.book(infy).stop_count() << " stops  best bid "
+                  << to_double(*live.best_bid(infy)) << "  best ask " << to_double(*live.best_ask(infy)) << "\n";
+
+        Order spare = stop(Side::SELL, OrderType::STOP, 1450.00, 0, 5);
+        live.submit(infy, spare);
+        bool cancelled = live.cancel(infy, spare.order_id);
+        bool amended   = live.modify(infy, spare.order_id, to_fixed(1460.00), 5, [](const Trade&) {});
+        std::cout << "  cancel waiting stop: " << (cancelled ? "yes" : "no")
+                  << "  modify waiting stop: " << (amended ? "yes" : "no") << "\n";
+
+        auto run = [&](Engine& engine, const char* what, const Order& order) {
+            std::cout << "  " << std::left << std::setw(18) << what << std::right << "->";
+            engine.submit(infy, order, [](const Trade& t) {
+                std::cout << " " << t.quantity << "@" << to_double(t.price);
+            });
+            std::cout << "   stops left " << engine.book(infy).stop_count() << "\n";
+        };
+        // prints at 1501 elect both 1501 buy stops, FIFO; the 1503 one is never reached
+        run(live, "buy 10 mkt", make_order(Side::BUY, OrderType::MARKET, 0, 10));
+        // prints down to 1498 elect the stop-limit, whose prints at 1497 elect the stop
+        run(live, "sell 200 mkt", make_order(Side::SELL, OrderType::MARKET, 0, 200));
+
+        save_snapshot_async(live, snapshot_path).get();
+        Engine restored;
+        load_snapshot(snapshot_path, restored);
+        std::cout << "  snapshot restored " << restored.book(infy).stop_count() << " stop\n";
+        Order lift = make_order(Side::BUY, OrderType::LIMIT, 1503.00, 120);
+        run(live, "buy 120 live", lift);
+        run(restored, "buy 120 restored", lift);
+
+        live.set_journal(nullptr);
+        journal.flush();
+        size_t replayed = 0;
+        Engine recovered;
+        JournalReader reader(path);
+        replay(reader, recovered, [&](const Trade&) { ++replayed; });
+        std::cout << "  replayed journal: " << replayed << " trades, resting=" << recovered.book(infy).order_count()
+                  << "  best ask " << to_double(*recovered.best_ask(infy))
+                  << "  (live " << live.book(infy).order_count() << ", " << to_double(*live.best_ask(infy)) << ")\n";
+
+        Order tagged    = stop(Side::BUY, OrderType::STOP, 1600.00, 0, 10);
+        tagged.order_id = ((uint64_t)3 << OWNER_SHIFT) | tagged.order_id;
+        live.submit(infy, tagged);
+        MassCancelReport pulled = live.mass_cancel(infy, CancelFilter::owned_by(3));
+        std::cout << "  mass cancel owner 3: orders=" << pulled.orders << "  stops left "
+                  << live.book(infy).stop_count() << "\n";
+        std::remove(path);
+        std::remove(snapshot_path);
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 25 — call auction, indications and the uncross\n";
+    std::cout << "========================================\n";
+    {
+        struct Indications : BookListener {
+            size_t            count = 0;
+            AuctionIndication last{};
+            void on_auction(const AuctionIndication& at) override { ++count; last = at; }
+        };
+        auto show = [](const AuctionIndication& at) {
+            std::cout << to_double(at.price) << " x " << at.volume << " imbalance " << at.imbalance;
+        };
+
+        const char*   path = "main_test_auction.journal";
+        Engine        live;
+        JournalWriter journal(path);
+        live.set_journal(&journal);
+        live.add_symbol("SBIN", InstrumentConfig{.tick_size = to_fixed(1.00), .min_price = to_fixed(90.00), .max_price = to_fixed(110.00)});
+        InstrumentId sbin = *live.find_symbol("SBIN");
+        Indications  feed;
+        live.set_listener(sbin, &feed);
+
+        // a buy stop waiting from continuous trading, elected by the auction print
+        Order stop      = make_order(Side::BUY, OrderType::STOP, 0, 50);
+        stop.stop_price = to_fixed(100.00);
+        live.submit(sbin, stop);
+
+        AuctionOptions options;
+        options.reference = to_fixed(100.00);
+        live.begin_auction(sbin, options);
+
+        for (auto [price, qty] : {std::pair{101.00, 300}, {100.00, 200}, {99.00, 200}})
+            live.submit(sbin, make_order(Side::BUY, OrderType::LIMIT, price, qty));
+        live.submit(sbin, make_order(Side::BUY, OrderType::MARKET, 0, 100));
+        for (auto [price, qty] : {std::pair{98.00, 200}, {99.00, 200}, {100.00, 300}, {102.00, 100}})
+            live.submit(sbin, make_order(Side::SELL, OrderType::LIMIT, price, qty));
+
+        Order ioc = make_order(Side::BUY, OrderType::LIMIT, 105.00, 500);
+        ioc.tif   = TimeInForce::IOC;
+        live.submit(sbin, ioc);
+        Order extra = make_order(Side::SELL, OrderType::LIMIT, 97.00, 50);
+        live.submit(sbin, extra);
+        std::cout << "  with a 97 seller: ";
+        show(live.indicative(sbin));
+        live.cancel(sbin, extra.order_id);
+        std::cout << "\n  after its cancel:  ";
+        show(live.indicative(sbin));
+        std::cout << "\n  crossed but untraded: best bid " << to_double(*live.best_bid(sbin))
+                  << "  best ask " << to_double(*live.best_ask(sbin)) << "  (IOC dropped)\n";
+        std::cout << "  indications published: " << feed.count << ", last ";
+        show(feed.last);
+        std::cout << "\n  uncross ->";
+        AuctionIndication done = live.uncross(sbin, [](const Trade& t) {
+            std::cout << " " << t.quantity << "@" << to_double(t.price);
+        });
+        std::cout << "\n  executed ";
+        show(done);
+        std::cout << "\n  after: in auction " << (live.book(sbin).in_auction() ? "yes" : "no")
+                  << "  stops " << live.book(sbin).stop_count() << "  best bid " << to_double(*live.best_bid(sbin))
+                  << "  best ask " << to_double(*live.best_ask(sbin)) << " x " << live.book(sbin).ask_quantity_at(to_fixed(100.00))
+                  << "  resting=" << live.book(sbin).order_count() << "\n";
+        live.set_listener(sbin, nullptr);
+
+        live.set_journal(nullptr);
+        journal.flush();
+        size_t        replayed = 0;
+        Engine        recovered;
+        JournalReader reader(path);
+        replay(reader, recovered, [&](const Trade&) { ++replayed; });
+        InstrumentId again = *recovered.find_symbol("SBIN");
+        std::cout << "  replayed journal: " << replayed << " trades, resting=" << recovered.book(again).order_count()
+                  << "  best ask " << to_double(*recovered.best_ask(again)) << "\n";
+        std::remove(path);
+
+        // tie-breaks on one crossed pair: 100 at 101 against 100 at 99 trades
+        // the same at either limit price, and 100 is equally near both
+        auto pick = [&](uint64_t buy_qty, std::optional<double> reference) {
+            OrderBook      book(BookMode::LADDER, InstrumentConfig{.tick_size = to_fixed(1.00), .min_price = to_fixed(90.00), .max_price = to_fixed(110.00)});
+            AuctionOptions call;
+            if (reference) call.reference = to_fixed(*reference);
+            book.begin_auction(call);
+            book.submit(make_order(Side::BUY,  OrderType::LIMIT, 101.00, (uint32_t)buy_qty));
+            book.submit(make_order(Side::SELL, OrderType::LIMIT,  99.00, 100));
+            return book.indicative();
+        };
+        std::cout << "  even, reference 102: ";
+        show(pick(100, 102.00));
+        std::cout << "\n  even, reference 100: ";
+        show(pick(100, 100.00));
+        std::cout << "\n  even, no reference:  ";
+        show(pick(100, std::nullopt));
+        std::cout << "\n  buyers over:         ";
+        show(pick(150, 100.00));
+        std::cout << "\n";
+
+        Engine calling;
+        calling.add_symbol("SBIN", InstrumentConfig{.tick_size = to_fixed(1.00), .min_price = to_fixed(90.00), .max_price = to_fixed(110.00)});
+        calling.begin_auction(0);
+        try {
+            capture_snapshot(calling);
+            std::cout << "  snapshot during the call: taken\n";
+        } catch (const std::logic_error&) {
+            std::cout << "  snapshot during the call: refused\n";
+        }
+    }
+
+    std::cout << "\n========================================\n";
+    std::cout << "  TEST 26 — parallel backtest, same stream at any thread count\n";
+    std::cout << "========================================\n";
+    {
+        FlowProfile profile;
+        profile.orders  = 100000;
+        profile.symbols = 40;
+        profile.seed    = 7;
+        const char* whole = "/tmp/orderbook_backtest.flow";
+        generate_flow(profile, whole);
+
+        // the same flow cut into two "days"; books must carry over the cut
+        const std::vector<std::string> days = {"/tmp/orderbook_backtest_1.flow", "/tmp/orderbook_backtest_2.flow"};
+        {
+            std::vector<char> bytes;
+            FILE* in = std::fopen(whole, "rb");
+            char  chunk[65536];
+            for (size_t n; (n = std::fread(chunk, 1, sizeof(chunk), in)) > 0;) bytes.insert(bytes.end(), chunk, chunk + n);
+            std::fclose(in);
+
+            const size_t head = sizeof(JournalHeader) + profile.symbols * sizeof(JournalRecord);
+            const size_t cut  = head + profile.orders / 2 * sizeof(JournalRecord);
+            for (size_t d = 0; d < 2; d++) {
+                FILE* out = std::fopen(days[d].c_str(), "wb");
+                std::fwrite(bytes.data(), 1, head, out);
+                if (d == 0) std::fwrite(bytes.data() + head, 1, cut - head, out);
+                else        std::fwrite(bytes.data() + cut, 1, bytes.size() - cut, out);
+                std::fclose(out);
+            }
+        }
+
+        std::vector<Trade> serial;
+        {
+            JournalReader flow(whole);
+            Engine        engine;
+            replay(flow, engine, [&](const Trade& t) { serial.push_back(t); });
+        }
+
+        auto same_trade = [](const Trade& a, const Trade& b) {
+            return a.buy_order_id == b.buy_order_id && a.sell_order_id == b.sell_order_id && a.price == b.price &&
+                   a.quantity == b.quantity && a.buy_account == b.buy_account && a.sell_account == b.sell_account;
+        };
+
+        std::vector<BacktestTrade> first;
+        for (size_t threads : {1, 2, 4, 8}) {
+            std::vector<BacktestTrade> stream;
+            BacktestReport report = run_backtest(days, [&](const BacktestTrade& t) { stream.push_back(t); }, threads);
+            if (first.empty()) first = stream;
+
+            bool identical = stream.size() == first.size() &&
+                             std::memcmp(stream.data(), first.data(), stream.size() * sizeof(BacktestTrade)) == 0;
+            bool as_serial = stream.size() == serial.size();
+            for (size_t i = 0; as_serial && i < stream.size(); i++) as_serial = same_trade(stream[i].trade, serial[i]);
+            std::cout << "  threads=" << threads << "  symbols=" << report.symbols << "  messages=" << report.messages
+                      << "  trades=" << report.trades << "  bytes as 1 thread: " << (identical ? "yes" : "NO")
+                      << "  as serial replay: " << (as_serial ? "yes" : "NO") << "\n";
+        }
+
+        bool ordered = std::is_sorted(first.begin(), first.end(), [](const BacktestTrade& a, const BacktestTrade& b) {
+            return a.timestamp < b.timestamp;
+        });
+        size_t second_day = std::count_if(first.begin(), first.end(), [](const BacktestTrade& t) { return t.file == 1; });
+        std::cout << "  timestamps non-decreasing: " << (ordered ? "yes" : "NO")
+                  << "  trades on day 2: " << second_day << "\n";
+
+        try {
+            run_backtest({days[0], "/tmp/orderbook_backtest_missing.flow"}, [](const BacktestTrade&) {}, 4);
+            std::cout << "  missing day: accepted\n";
+        } catch (const std::runtime_error&) {
+            std::cout << "  missing day: rejected\n";
+        }
+        std::remove(whole);
+        for (const std::string& day : days) std::remove(day.c_str());
+    }
+
     std::cout << "\n========================================\n";
     std::cout << "  ALL TESTS DONE\n";
     std::cout << "========================================\n";
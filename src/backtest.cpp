@@ -0,0 +1,175 @@
+#include "../include/backtest.hpp"
+#include "../include/engine.hpp"
+#include "../include/journal.hpp"
+#include "../include/work_stealing_pool.hpp"
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+namespace {
+
+// one input file, mapped and split by the file's own instrument ids
+struct FileSplit {
+    std::unique_ptr<JournalReader>     reader;
+    std::vector<uint32_t>              symbol_records;  // first SYMBOL record per instrument, in file order
+    std::vector<std::vector<uint32_t>> records;         // by file instrument id: message record indices
+
+    // trades printed by each record, filled in by the one book that owns the
+    // record, then turned in place into each record's first output slot
+    std::vector<uint32_t> fills;
+    uint64_t              total = 0;  // trades from this file
+};
+
+struct BacktestSymbol {
+    std::string      name;
+    InstrumentConfig config;
+    BookMode         mode;
+    uint64_t         messages = 0;
+    std::vector<std::pair<uint32_t, InstrumentId>> sources;  // (file, file instrument id), in file order
+};
+
+void split_file(const std::string& path, FileSplit& split) {
+    split.reader = std::make_unique<JournalReader>(path);
+    const JournalRecord* records = split.reader->begin();
+    const size_t         count   = split.reader->size();
+    if (count > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error("too many records for a backtest input: " + path);
+    split.fills.assign(count, 0);
+
+    std::vector<bool> registered;
+    for (uint32_t i = 0; i < count; i++) {
+        const JournalRecord& record = records[i];
+        const InstrumentId   id     = record.instrument;
+
+        if (record.type == JournalRecordType::SYMBOL) {
+            if (registered.size() <= id) {
+                registered.resize(id + 1);
+                split.records.resize(id + 1);
+            }
+            if (!registered[id]) split.symbol_records.push_back(i);
+            registered[id] = true;
+            continue;
+        }
+        if (record.type != JournalRecordType::ORDER && record.type != JournalRecordType::MASS_CANCEL &&
+            record.type != JournalRecordType::AUCTION)
+            throw std::runtime_error("unknown record type in " + path);
+        if (id >= registered.size() || !registered[id])
+            throw std::runtime_error("record for an unregistered instrument in " + path);
+        split.records[id].push_back(i);
+    }
+}
+
+}  // namespace
+
+BacktestReport run_backtest(const std::vector<std::string>& paths, BacktestSink on_trade, size_t threads) {
+    BacktestReport   report;
+    WorkStealingPool pool(threads);
+    report.files   = paths.size();
+    report.threads = pool.threads();
+
+    // 1. map and split every file, each on its own worker
+    uint64_t start = now_ns();
+    std::vector<FileSplit> splits(paths.size());
+    pool.run(paths.size(), [&](size_t f) { split_file(paths[f], splits[f]); });
+
+    // symbols by name across files, numbered in order of first registration
+    std::vector<BacktestSymbol>                   symbols;
+    std::unordered_map<std::string, InstrumentId> by_name;
+    for (uint32_t f = 0; f < splits.size(); f++) {
+        const JournalRecord* records = splits[f].reader->begin();
+        for (uint32_t r : splits[f].symbol_records) {
+            const JournalRecord& record = records[r];
+            std::string name(record.symbol.name, strnlen(record.symbol.name, sizeof(record.symbol.name)));
+
+            auto [it, fresh] = by_name.emplace(name, (InstrumentId)symbols.size());
+            if (fresh) {
+                symbols.push_back(BacktestSymbol{
+                    name,
+                    InstrumentConfig{record.symbol.tick_size, record.symbol.min_price, record.symbol.max_price},
+                    (BookMode)record.symbol.mode, 0, {}});
+            }
+            BacktestSymbol& symbol = symbols[it->second];
+            symbol.sources.emplace_back(f, record.instrument);
+            symbol.messages += splits[f].records[record.instrument].size();
+        }
+    }
+    report.symbols      = symbols.size();
+    report.partition_ns = now_ns() - start;
+
+    // 2. every symbol's history through its own book, longest first
+    start = now_ns();
+    std::vector<uint64_t>                   cost(symbols.size());
+    std::vector<std::vector<BacktestTrade>> trades(symbols.size());
+    for (size_t s = 0; s < symbols.size(); s++) {
+        cost[s]          = symbols[s].messages;
+        report.messages += symbols[s].messages;
+    }
+
+    pool.run(symbols.size(), [&](size_t s) {
+        const BacktestSymbol& symbol = symbols[s];
+        Engine engine;  // one per book, so its node pool stays on the worker that fills it
+        if (symbol.mode == BookMode::LADDER) engine.add_symbol(symbol.name, symbol.config, symbol.mode);
+        const InstrumentId id = engine.intern(symbol.name);
+
+        std::vector<BacktestTrade>& out       = trades[s];
+        uint64_t                    timestamp = 0;
+        for (auto [f, local] : symbol.sources) {
+            const JournalRecord* records = splits[f].reader->begin();
+            for (uint32_t r : splits[f].records[local]) {
+                const JournalRecord& record = records[r];
+                if (record.type == JournalRecordType::ORDER) timestamp = record.order.timestamp;
+
+                uint32_t fill = 0;
+                apply_record(record, engine, id, [&](const Trade& trade) {
+                    out.push_back(BacktestTrade{timestamp, r, f, fill++, (InstrumentId)s, 0, trade});
+                });
+                splits[f].fills[r] = fill;
+            }
+        }
+    }, cost.data());
+    report.steals   = pool.steals();
+    report.match_ns = now_ns() - start;
+
+    // 3. every trade's final position is known without comparing keys: the
+    // file's base, plus the trades of earlier records in it, plus its fill
+    // number. Prefix sums per file, then every book scatters its own trades.
+    start = now_ns();
+    pool.run(splits.size(), [&](size_t f) {
+        uint64_t sum = 0;
+        for (uint32_t& fills : splits[f].fills) {
+            uint32_t n = fills;
+            fills      = (uint32_t)sum;
+            sum       += n;
+        }
+        splits[f].total = sum;
+    });
+
+    std::vector<uint64_t> base(splits.size());
+    for (size_t f = 0; f < splits.size(); f++) {
+        base[f]        = report.trades;
+        report.trades += splits[f].total;
+        if (splits[f].total > std::numeric_limits<uint32_t>::max())
+            throw std::runtime_error("too many trades from one backtest input: " + paths[f]);
+    }
+
+    std::unique_ptr<BacktestTrade[]> merged(new BacktestTrade[report.trades]);
+    pool.run(trades.size(), [&](size_t s) {
+        for (const BacktestTrade& trade : trades[s])
+            merged[base[trade.file] + splits[trade.file].fills[trade.record] + trade.fill] = trade;
+        std::vector<BacktestTrade>().swap(trades[s]);
+    }, cost.data());
+    report.merge_ns = now_ns() - start;
+
+    start = now_ns();
+    for (size_t i = 0; i < report.trades; i++) on_trade(merged[i]);
+    report.output_ns = now_ns() - start;
+    return report;
+}
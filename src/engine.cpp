@@ -1,41 +1,281 @@
 #include "../include/engine.hpp"
+#include "../include/journal.hpp"
+#include <algorithm>
+#include <ctime>
+#include <stdexcept>
 
-OrderBook* Engine::get_book(const std::string& symbol) {
-    auto it = books_.find(symbol);
-    if (it == books_.end()) return nullptr;
-    return &it->second;
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
 }
 
 const OrderBook* Engine::get_book_const(const std::string& symbol) const {
-    auto it = books_.find(symbol);
-    if (it == books_.end()) return nullptr;
-    return &it->second;
+    auto id = symbols_.find(symbol);
+    if (!id) return nullptr;
+    return &books_[*id];
+}
+
+bool Engine::add_symbol(const std::string& symbol, const InstrumentConfig& config,
+                        BookMode mode) {
+    if (symbols_.find(symbol)) return false;
+    InstrumentId id = symbols_.intern(symbol);
+    books_.emplace_back(mode, config, pool_.get());
+    books_.back().set_metrics(metrics_);
+    books_.back().set_risk(risk_);
+    if (journal_) journal_symbol(id);
+    return true;
+}
+
+InstrumentId Engine::intern(const std::string& symbol) {
+    InstrumentId id = symbols_.intern(symbol);
+    if (id == books_.size()) {
+        books_.emplace_back(pool_.get());
+        books_.back().set_metrics(metrics_);
+        books_.back().set_risk(risk_);
+        if (journal_) journal_symbol(id);
+    }
+    return id;
+}
+
+void Engine::set_journal(JournalWriter* journal) {
+    journal_ = journal;
+    if (!journal_) return;
+    for (InstrumentId id = 0; id < books_.size(); id++)
+        journal_symbol(id);
+}
+
+void Engine::set_metrics(EngineMetrics* metrics) {
+    metrics_ = metrics;
+    for (OrderBook& book : books_) book.set_metrics(metrics);
+}
+
+void Engine::set_risk(PreTradeRisk* risk) {
+    risk_ = risk;
+    for (OrderBook& book : books_) book.set_risk(risk);
+}
+
+void Engine::journal_symbol(InstrumentId id) {
+    journal_->append_symbol(id, symbols_.name(id), books_[id].config(), books_[id].mode());
+}
+
+std::optional<InstrumentId> Engine::find_symbol(const std::string& symbol) const {
+    return symbols_.find(symbol);
+}
+
+RiskResult Engine::submit(InstrumentId id, Order order, TradeSink on_trade) {
+    return process(id, books_[id], order, on_trade);
+}
+
+RiskResult Engine::process(InstrumentId id, OrderBook& book, const Order& order, TradeSink& on_trade) {
+    const bool timed = metrics_ && metrics_->sample(Stage::SUBMIT);
+    uint64_t   t0    = timed ? tsc_now() : 0;
+
+    // a price the book would refuse is refused before the gate counts the
+    // order or the journal records it; without either the book checks alone
+    if (risk_ || journal_) book.validate(order);
+
+    if (risk_) {
+        RiskResult verdict = risk_->check(order, book);
+        if (verdict != RiskResult::ACCEPTED) {
+            if (timed) metrics_->record(Stage::SUBMIT, tsc_now() - t0);
+            return verdict;
+        }
+    }
+
+    if (journal_) journal_->append_order(id, order);
+
+    if (risk_) {
+        book.submit(order, [&](const Trade& trade) {
+            risk_->on_trade(trade);
+            on_trade(trade);
+        });
+    } else {
+        book.submit(order, on_trade);
+    }
+
+    if (timed) metrics_->record(Stage::SUBMIT, tsc_now() - t0);
+    return RiskResult::ACCEPTED;
+}
+
+std::vector<Trade> Engine::submit(InstrumentId id, Order order) {
+    std::vector<Trade> trades;
+    submit(id, order, [&](const Trade& trade) { trades.push_back(trade); });
+    return trades;
+}
+
+bool Engine::cancel(InstrumentId id, uint64_t order_id) {
+    if (journal_) {
+        Order cancel{};
+        cancel.order_id = order_id;
+        cancel.type     = OrderType::CANCEL;
+        journal_->append_order(id, cancel);
+    }
+    return books_[id].cancel(order_id);
+}
+
+MassCancelReport Engine::mass_cancel(InstrumentId id, const CancelFilter& filter) {
+    if (journal_) journal_->append_mass_cancel(id, filter);
+    return books_[id].mass_cancel(filter);
+}
+
+MassCancelReport Engine::mass_cancel(const CancelFilter& filter) {
+    MassCancelReport report;
+    for (InstrumentId id = 0; id < books_.size(); id++)
+        if (books_[id].order_count() > 0) report += mass_cancel(id, filter);
+    return report;
+}
+
+void Engine::begin_auction(InstrumentId id, const AuctionOptions& options) {
+    if (journal_) journal_->append_auction(id, JournalAuction::BEGIN, options);
+    books_[id].begin_auction(options);
+}
+
+AuctionIndication Engine::uncross(InstrumentId id, TradeSink on_trade) {
+    if (journal_) journal_->append_auction(id, JournalAuction::UNCROSS, {});
+    if (!risk_) return books_[id].uncross(on_trade);
+    return books_[id].uncross([&](const Trade& trade) {
+        risk_->on_trade(trade);
+        on_trade(trade);
+    });
+}
+
+bool Engine::modify(InstrumentId id, uint64_t order_id, Price price, uint64_t quantity,
+                    TradeSink on_trade) {
+    if (journal_ || risk_) {
+        Order amend{};
+        amend.order_id  = order_id;
+        amend.price     = price;
+        amend.quantity  = quantity;
+        amend.type      = OrderType::MODIFY;
+        amend.timestamp = now_ns();  // the rate window runs on message time
+        books_[id].validate(amend);
+        if (risk_ && risk_->check(amend, books_[id]) != RiskResult::ACCEPTED) return false;
+        if (journal_) journal_->append_order(id, amend);
+    }
+    if (!risk_) return books_[id].modify(order_id, price, quantity, on_trade);
+
+    // a repriced order can cross, and its fills move positions like any other
+    return books_[id].modify(order_id, price, quantity, [&](const Trade& trade) {
+        risk_->on_trade(trade);
+        on_trade(trade);
+    });
+}
+
+void Engine::submit_batch(const OrderMessage* messages, size_t count, BatchResult& result) {
+    result.trades.clear();
+    result.fills.assign(count, BatchFill{0, 0, false, RiskResult::ACCEPTED});
+
+    // group by book: sort (instrument, arrival index) keys, so each book's
+    // messages stay in arrival order and the scratch buffer is reused
+    std::vector<uint64_t>& order = result.order;
+    order.resize(count);
+    for (uint32_t i = 0; i < count; i++)
+        order[i] = ((uint64_t)messages[i].instrument << 32) | i;
+    std::sort(order.begin(), order.end());
+
+    auto      on_trade = [&](const Trade& trade) { result.trades.push_back(trade); };
+    TradeSink sink     = on_trade;
+
+    size_t i = 0;
+    while (i < count) {
+        InstrumentId id   = messages[(uint32_t)order[i]].instrument;
+        OrderBook&   book = books_[id];
+
+        size_t group_end = i;
+        while (group_end < count && messages[(uint32_t)order[group_end]].instrument == id) ++group_end;
+        if (group_end < count) {
+            const OrderMessage& next = messages[(uint32_t)order[group_end]];
+            books_[next.instrument].prefetch(next.order);
+        }
+
+        for (; i < group_end; i++) {
+            const OrderMessage& msg  = messages[(uint32_t)order[i]];
+            BatchFill&          fill = result.fills[(uint32_t)order[i]];
+
+            fill.begin = (uint32_t)result.trades.size();
+            try {
+                fill.risk     = process(id, book, msg.order, sink);
+                fill.rejected = (fill.risk != RiskResult::ACCEPTED);
+            } catch (const std::out_of_range&) {
+                fill.rejected = true;
+            }
+            fill.count = (uint32_t)result.trades.size() - fill.begin;
+        }
+    }
+}
+
+void Engine::reserve(InstrumentId id, size_t orders) {
+    books_[id].reserve(orders);
+    reserved_orders_ += orders;
+    pool_->reserve(reserved_orders_);
+}
+
+MemoryUsage Engine::memory() const {
+    MemoryUsage usage;
+    for (const OrderBook& book : books_) usage += book.memory();
+    usage.node_bytes = pool_->memory_bytes();
+    return usage;
+}
+
+std::optional<Price> Engine::best_bid(InstrumentId id) const {
+    return books_[id].best_bid();
+}
+
+std::optional<Price> Engine::best_ask(InstrumentId id) const {
+    return books_[id].best_ask();
+}
+
+std::optional<Price> Engine::spread(InstrumentId id) const {
+    return books_[id].spread();
+}
+
+RiskResult Engine::submit(const std::string& symbol, Order order, TradeSink on_trade) {
+    return submit(resolve(symbol), order, on_trade);
 }
 
 std::vector<Trade> Engine::submit(const std::string& symbol, Order order) {
-    return books_[symbol].submit(order);
+    return submit(resolve(symbol), order);
+}
+
+InstrumentId Engine::resolve(const std::string& symbol) {
+    if (!metrics_ || !metrics_->sample(Stage::LOOKUP)) return intern(symbol);
+    uint64_t     t0 = tsc_now();
+    InstrumentId id = intern(symbol);
+    metrics_->record(Stage::LOOKUP, tsc_now() - t0);
+    return id;
 }
 
 bool Engine::cancel(const std::string& symbol, uint64_t order_id) {
-    OrderBook* book = get_book(symbol);
-    if (!book) return false;
-    return book->cancel(order_id);
+    const bool timed = metrics_ && metrics_->sample(Stage::LOOKUP);
+    uint64_t   t0    = timed ? tsc_now() : 0;
+    auto       id    = symbols_.find(symbol);
+    if (timed) metrics_->record(Stage::LOOKUP, tsc_now() - t0);
+    if (!id) return false;
+    return cancel(*id, order_id);
 }
 
-std::optional<double> Engine::best_bid(const std::string& symbol) const {
+bool Engine::modify(const std::string& symbol, uint64_t order_id, Price price,
+                    uint64_t quantity, TradeSink on_trade) {
+    auto id = symbols_.find(symbol);
+    if (!id) return false;
+    return modify(*id, order_id, price, quantity, on_trade);
+}
+
+std::optional<Price> Engine::best_bid(const std::string& symbol) const {
     const OrderBook* book = get_book_const(symbol);
     if (!book) return std::nullopt;
     return book->best_bid();
 }
 
-std::optional<double> Engine::best_ask(const std::string& symbol) const {
+std::optional<Price> Engine::best_ask(const std::string& symbol) const {
     const OrderBook* book = get_book_const(symbol);
     if (!book) return std::nullopt;
     return book->best_ask();
 }
 
-std::optional<double> Engine::spread(const std::string& symbol) const {
+std::optional<Price> Engine::spread(const std::string& symbol) const {
     const OrderBook* book = get_book_const(symbol);
     if (!book) return std::nullopt;
     return book->spread();
-}
\ No newline at end of file
+}
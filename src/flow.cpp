@@ -0,0 +1,177 @@
+#include "../include/flow.hpp"
+#include "../include/journal.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// splitmix64. <random> engines are portable but its distributions are not, so
+// every draw below is derived from raw 64-bit outputs by hand.
+class FlowRng {
+public:
+    explicit FlowRng(uint64_t seed) : state_(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    double   uniform()          { return (double)(next() >> 11) * 0x1.0p-53; }  // [0, 1)
+    uint64_t below(uint64_t n)  { return next() % n; }
+
+    // index into a cumulative weight table
+    size_t pick(const std::vector<double>& cdf) {
+        double u = uniform() * cdf.back();
+        return std::upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+    }
+
+private:
+    uint64_t state_;
+};
+
+struct LiveOrder {
+    uint64_t id;
+    int64_t  tick;
+    Side     side;
+};
+
+struct SymbolState {
+    int64_t                mid;   // ticks above the band floor
+    std::vector<LiveOrder> live;  // may still rest; fills are not tracked here
+};
+
+}  // namespace
+
+size_t generate_flow(const FlowProfile& profile, const std::string& path) {
+    FlowRng rng(profile.seed);
+
+    InstrumentConfig config{to_fixed(profile.tick_size), to_fixed(profile.base_price * 0.5),
+                            to_fixed(profile.base_price * 1.5)};
+    const int64_t    top    = config.to_ticks(config.max_price);
+    const int64_t    margin = (int64_t)profile.depth_levels + 4;
+
+    std::vector<double> popularity(profile.symbols);
+    double total = 0;
+    for (size_t k = 0; k < profile.symbols; k++) {
+        total += 1.0 / std::pow((double)(k + 1), profile.zipf_s);
+        popularity[k] = total;
+    }
+
+    std::vector<double> depth(profile.depth_levels);
+    double weight = 1.0;
+    total = 0;
+    for (uint32_t k = 0; k < profile.depth_levels; k++) {
+        total   += weight;
+        depth[k] = total;
+        weight  *= 1.0 - profile.depth_decay;
+    }
+
+    JournalWriter writer(path, JournalOptions{SyncPolicy::NONE, 4096});
+
+    std::vector<SymbolState> symbols(profile.symbols);
+    for (size_t s = 0; s < profile.symbols; s++) {
+        char name[24];
+        std::snprintf(name, sizeof(name), "SYM%05zu", s);
+        writer.append_symbol((InstrumentId)s, name, config, BookMode::LADDER);
+        symbols[s].mid = config.to_ticks(to_fixed(profile.base_price));
+    }
+
+    auto quantity = [&] { return (uint64_t)profile.lot * (1 + rng.below(10)); };
+
+    // a passive price k ticks behind the touch, the touch sitting one tick off the mid
+    auto passive_tick = [&](const SymbolState& sym, Side side) {
+        int64_t behind = 1 + (int64_t)rng.pick(depth);
+        return side == Side::BUY ? sym.mid - behind : sym.mid + behind;
+    };
+
+    const double cancel_at  = profile.cancel_ratio;
+    const double replace_at = cancel_at + profile.replace_ratio;
+    const double market_at  = replace_at + profile.market_ratio;
+
+    for (size_t i = 0; i < profile.orders; i++) {
+        InstrumentId id  = (InstrumentId)rng.pick(popularity);
+        SymbolState& sym = symbols[id];
+
+        if (rng.uniform() < profile.drift) {
+            sym.mid += (rng.next() & 1) ? 1 : -1;
+            sym.mid  = std::clamp(sym.mid, margin, top - margin);
+        }
+
+        Order order{};
+        order.order_id  = i + 1;
+        order.timestamp = (uint64_t)i * 1000;  // 1 message per microsecond
+        order.account   = (uint32_t)rng.below(64);
+        order.side      = (rng.next() & 1) ? Side::BUY : Side::SELL;
+
+        double roll = rng.uniform();
+        if (roll < replace_at && !sym.live.empty()) {
+            size_t     at   = rng.below(sym.live.size());
+            LiveOrder& live = sym.live[at];
+            order.order_id = live.id;
+
+            if (roll < cancel_at) {
+                order.type = OrderType::CANCEL;
+                live = sym.live.back();
+                sym.live.pop_back();
+            } else {
+                // half the replaces only resize, the rest also move to a fresh passive price
+                order.type     = OrderType::MODIFY;
+                order.quantity = quantity();
+                if (rng.next() & 1) live.tick = passive_tick(sym, live.side);
+                order.price    = config.to_price(live.tick);
+            }
+        } else if (roll >= replace_at && roll < market_at) {
+            order.type     = OrderType::MARKET;
+            order.quantity = quantity();
+        } else {
+            int64_t tick;
+            if (rng.uniform() < profile.cross_ratio) {
+                int64_t through = 1 + (int64_t)rng.below(3);
+                tick = order.side == Side::BUY ? sym.mid + through : sym.mid - through;
+            } else {
+                tick = passive_tick(sym, order.side);
+            }
+            order.type     = OrderType::LIMIT;
+            order.price    = config.to_price(tick);
+            order.quantity = quantity();
+            sym.live.push_back(LiveOrder{order.order_id, tick, order.side});
+        }
+
+        writer.append_order(id, order);
+    }
+
+    writer.flush();
+    return profile.orders;
+}
+
+std::vector<OrderMessage> load_flow(const std::string& path, Engine& engine) {
+    JournalReader             journal(path);
+    std::vector<InstrumentId> ids;  // flow id -> engine id, as replay() maps them
+    std::vector<OrderMessage> messages;
+    messages.reserve(journal.size());
+
+    for (const JournalRecord& record : journal) {
+        if (record.type == JournalRecordType::SYMBOL) {
+            std::string name(record.symbol.name, strnlen(record.symbol.name, sizeof(record.symbol.name)));
+            InstrumentConfig config{record.symbol.tick_size, record.symbol.min_price, record.symbol.max_price};
+            BookMode mode = (BookMode)record.symbol.mode;
+
+            if (mode == BookMode::LADDER) engine.add_symbol(name, config, mode);
+            if (ids.size() <= record.instrument) ids.resize(record.instrument + 1);
+            ids[record.instrument] = engine.intern(name);
+            continue;
+        }
+        if (record.type == JournalRecordType::MASS_CANCEL || record.type == JournalRecordType::AUCTION)
+            continue;  // not messages
+        if (record.type != JournalRecordType::ORDER)
+            throw std::runtime_error("unknown record type in " + path);
+        messages.push_back(OrderMessage{ids[record.instrument], journal_order(record)});
+    }
+    return messages;
+}
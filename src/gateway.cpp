@@ -0,0 +1,650 @@
+#include "../include/gateway.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <ctime>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// epoll user data: a session id for connections, these for the listeners
+static const uint64_t TCP_LISTENER  = ~uint64_t(0);
+static const uint64_t UNIX_LISTENER = ~uint64_t(0) - 1;
+static const uint64_t DOORBELL      = ~uint64_t(0) - 2;
+
+static const size_t RX_BUFFER = 64 * 1024;
+
+static std::runtime_error sys_error(const std::string& what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void pin_to(std::thread& thread, int core) {
+    unsigned cores = std::thread::hardware_concurrency();
+    if (core < 0 || cores == 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core % cores, &set);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+}
+
+static void ring(int bell) {
+    uint64_t one = 1;
+    ssize_t  rc  = ::write(bell, &one, sizeof(one));
+    (void)rc;  // the counter only overflows after 2^64 - 1 unread rings
+}
+
+static sockaddr_un unix_address(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) throw std::invalid_argument("unix socket path too long: " + path);
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return addr;
+}
+
+const char* to_string(AckStatus status) {
+    switch (status) {
+        case AckStatus::ACCEPTED:           return "accepted";
+        case AckStatus::RISK_REJECTED:      return "risk rejected";
+        case AckStatus::BAD_PRICE:          return "bad price";
+        case AckStatus::UNKNOWN_ORDER:      return "unknown order";
+        case AckStatus::UNKNOWN_INSTRUMENT: return "unknown instrument";
+        case AckStatus::BAD_ORDER_ID:       return "bad order id";
+    }
+    return "unknown";
+}
+
+Gateway::Gateway(Engine& engine, GatewayOptions options)
+    : engine_(engine), options_(std::move(options)),
+      inbound_(options_.queue_capacity), outbound_(options_.queue_capacity) {}
+
+Gateway::~Gateway() {
+    stop();
+    for (int fd : {tcp_fd_, unix_fd_, epoll_fd_, io_bell_, match_bell_})
+        if (fd >= 0) ::close(fd);
+    if (unix_fd_ >= 0) ::unlink(options_.unix_path.c_str());
+}
+
+void Gateway::start() {
+    if (running_.load()) return;
+    instruments_ = engine_.instrument_count();
+
+    epoll_fd_   = epoll_create1(0);
+    io_bell_    = eventfd(0, EFD_NONBLOCK);
+    match_bell_ = eventfd(0, 0);
+    if (epoll_fd_ < 0 || io_bell_ < 0 || match_bell_ < 0) throw sys_error("epoll/eventfd");
+
+    epoll_event bell{};
+    bell.events   = EPOLLIN;
+    bell.data.u64 = DOORBELL;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, io_bell_, &bell);
+
+    auto listen_on = [&](int fd, uint64_t tag) {
+        if (::listen(fd, 128) != 0) throw sys_error("listen");
+        epoll_event ev{};
+        ev.events   = EPOLLIN;
+        ev.data.u64 = tag;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+    };
+
+    if (options_.tcp_port >= 0) {
+        tcp_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (tcp_fd_ < 0) throw sys_error("socket");
+        int on = 1;
+        setsockopt(tcp_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+        sockaddr_in addr{};
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port        = htons((uint16_t)options_.tcp_port);
+        if (::bind(tcp_fd_, (sockaddr*)&addr, sizeof(addr)) != 0)
+            throw sys_error("bind 127.0.0.1:" + std::to_string(options_.tcp_port));
+
+        socklen_t len = sizeof(addr);
+        getsockname(tcp_fd_, (sockaddr*)&addr, &len);
+        tcp_port_ = ntohs(addr.sin_port);
+        listen_on(tcp_fd_, TCP_LISTENER);
+    }
+
+    if (!options_.unix_path.empty()) {
+        sockaddr_un addr = unix_address(options_.unix_path);
+        unix_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (unix_fd_ < 0) throw sys_error("socket");
+        ::unlink(options_.unix_path.c_str());
+        if (::bind(unix_fd_, (sockaddr*)&addr, sizeof(addr)) != 0)
+            throw sys_error("bind " + options_.unix_path);
+        listen_on(unix_fd_, UNIX_LISTENER);
+    }
+
+    running_       = true;
+    reading_done_  = false;
+    matching_done_ = false;
+    match_thread_  = std::thread([this] { run_matching(); });
+    io_thread_     = std::thread([this] { run_io(); });
+    pin_to(match_thread_, options_.match_core);
+    pin_to(io_thread_, options_.io_core);
+}
+
+void Gateway::stop() {
+    if (!running_.exchange(false)) return;
+    ring(io_bell_);
+    if (io_thread_.joinable())    io_thread_.join();
+    if (match_thread_.joinable()) match_thread_.join();
+}
+
+// ---------------------------------------------------------------------------
+// I/O thread
+
+void Gateway::run_io() {
+    epoll_event events[64];
+    unsigned    idle = 0;
+
+    while (running_.load(std::memory_order_acquire)) {
+        // poll while an answer is owed, unless that has gone on for a while;
+        // then sleep until a socket or the matching thread's doorbell wakes us
+        bool park = in_flight_ == 0 || idle >= options_.spin_polls;
+        if (park) {
+            io_parked_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            park = outbound_.empty() && running_.load(std::memory_order_relaxed);
+        }
+        int ready = epoll_wait(epoll_fd_, events, 64, park ? -1 : 0);
+        io_parked_.store(false, std::memory_order_relaxed);
+
+        for (int i = 0; i < ready; i++) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == DOORBELL) {
+                uint64_t rings;
+                ssize_t  rc = ::read(io_bell_, &rings, sizeof(rings));
+                (void)rc;
+                continue;
+            }
+            if (tag == TCP_LISTENER)  { accept_all(tcp_fd_);  continue; }
+            if (tag == UNIX_LISTENER) { accept_all(unix_fd_); continue; }
+
+            auto it = sessions_.find((uint32_t)tag);
+            if (it == sessions_.end()) continue;
+            Connection& conn = *it->second;
+
+            bool alive = !(events[i].events & (EPOLLERR | EPOLLHUP)) || (events[i].events & EPOLLIN);
+            if (alive && (events[i].events & EPOLLIN))  alive = read_from(conn);
+            if (alive && (events[i].events & EPOLLOUT)) alive = flush(conn);
+            if (!alive) close_session(conn.session);
+        }
+
+        bool busy = ready > 0;
+        if (drain_reports()) busy = true;
+        flush_dirty();
+        idle = busy ? 0 : idle + 1;
+    }
+
+    // no more requests; hand out everything the matching thread still produces
+    reading_done_.store(true, std::memory_order_release);
+    ring(match_bell_);
+    Backoff backoff;
+    while (!matching_done_.load(std::memory_order_acquire) || !outbound_.empty()) {
+        if (drain_reports()) backoff.reset();
+        else                 backoff.pause();
+    }
+    flush_dirty();
+
+    // whatever the socket buffers could not take is lost with the connection
+    for (auto& [session, conn] : sessions_) ::close(conn->fd);
+    sessions_.clear();
+    dirty_.clear();
+}
+
+void Gateway::accept_all(int listener) {
+    for (;;) {
+        int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK);
+        if (fd < 0) return;  // EAGAIN, or a connection that died in the backlog
+
+        if (listener == tcp_fd_) {
+            int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        }
+
+        // session tags are 24 bits: wrap within [1, OWNER_LIMIT), skipping any
+        // still connected, so none aliases owner 0 or a live session
+        uint32_t session = next_session_;
+        while (sessions_.count(session)) session = (session + 1 < OWNER_LIMIT) ? session + 1 : 1;
+        next_session_ = (session + 1 < OWNER_LIMIT) ? session + 1 : 1;
+        auto conn = std::make_unique<Connection>();
+        conn->fd      = fd;
+        conn->session = session;
+        conn->rx.resize(RX_BUFFER);
+
+        epoll_event ev{};
+        ev.events   = EPOLLIN;
+        ev.data.u64 = session;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+        sessions_.emplace(session, std::move(conn));
+    }
+}
+
+// One read per readiness event keeps a busy client from starving the others;
+// level-triggered epoll reports the socket again if more is waiting.
+bool Gateway::read_from(Connection& conn) {
+    ssize_t got = ::read(conn.fd, conn.rx.data() + conn.rx_len, conn.rx.size() - conn.rx_len);
+    if (got == 0) return false;
+    if (got < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    conn.rx_len += (size_t)got;
+
+    const unsigned char* data   = conn.rx.data();
+    size_t               offset = 0;
+    while (conn.rx_len - offset >= sizeof(MsgHeader)) {
+        MsgHeader header;
+        std::memcpy(&header, data + offset, sizeof(header));
+        if (header.length < sizeof(MsgHeader) || header.length > MAX_FRAME) return false;
+        if (conn.rx_len - offset < header.length) break;
+
+        if (!decode(conn, data + offset, header.type, header.length)) return false;
+        offset += header.length;
+    }
+
+    // keep the partial frame, if any, at the front
+    std::memmove(conn.rx.data(), data + offset, conn.rx_len - offset);
+    conn.rx_len -= offset;
+    return true;
+}
+
+bool Gateway::decode(Connection& conn, const unsigned char* frame, MsgType type, uint16_t length) {
+    Request request;
+    request.session = conn.session;
+    Order& order    = request.order;
+    order           = Order{};
+    order.timestamp = now_ns();
+
+    switch (type) {
+        case MsgType::NEW_ORDER: {
+            if (length != sizeof(NewOrderMsg)) return false;
+            NewOrderMsg msg;
+            std::memcpy(&msg, frame, sizeof(msg));
+            if (msg.side > (uint8_t)Side::SELL || msg.type > (uint8_t)OrderType::STOP_LIMIT ||
+                msg.type == (uint8_t)OrderType::CANCEL || msg.type == (uint8_t)OrderType::MODIFY ||
+                msg.tif > (uint8_t)TimeInForce::FOK)
+                return false;
+
+            request.instrument      = msg.instrument;
+            request.client_order_id = msg.client_order_id;
+            request.sent_at         = msg.sent_at;
+            order.price             = msg.price;
+            order.quantity          = msg.quantity;
+            order.account           = msg.account;
+            order.side              = (Side)msg.side;
+            order.type              = (OrderType)msg.type;
+            order.tif               = (TimeInForce)msg.tif;
+            order.post_only         = msg.post_only != 0;
+            order.display_quantity  = msg.display_quantity;
+            break;
+        }
+        case MsgType::CANCEL: {
+            if (length != sizeof(CancelMsg)) return false;
+            CancelMsg msg;
+            std::memcpy(&msg, frame, sizeof(msg));
+            request.instrument      = msg.instrument;
+            request.client_order_id = msg.client_order_id;
+            request.sent_at         = msg.sent_at;
+            order.type              = OrderType::CANCEL;
+            break;
+        }
+        case MsgType::MODIFY: {
+            if (length != sizeof(ModifyMsg)) return false;
+            ModifyMsg msg;
+            std::memcpy(&msg, frame, sizeof(msg));
+            request.instrument      = msg.instrument;
+            request.client_order_id = msg.client_order_id;
+            request.sent_at         = msg.sent_at;
+            order.price             = msg.price;
+            order.quantity          = msg.quantity;
+            order.type              = OrderType::MODIFY;
+            break;
+        }
+        default:
+            return false;
+    }
+
+    order.order_id = ((uint64_t)conn.session << SESSION_SHIFT) | (request.client_order_id & CLIENT_ID_MASK);
+    enqueue(request);
+    return true;
+}
+
+void Gateway::enqueue(const Request& request) {
+    // a full ring may mean the matching thread is waiting on outbound space
+    Backoff backoff;
+    while (!inbound_.try_push(request)) {
+        drain_reports();
+        backoff.pause();
+    }
+    ++in_flight_;
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (match_parked_.load(std::memory_order_relaxed)) ring(match_bell_);
+}
+
+size_t Gateway::drain_reports() {
+    size_t drained = 0;
+    Report report;
+    while (outbound_.try_pop(report)) {
+        ++drained;
+        MsgHeader header;
+        std::memcpy(&header, report.frame, sizeof(header));
+        if (header.type == MsgType::ACK) --in_flight_;
+
+        auto it = sessions_.find(report.session);
+        if (it == sessions_.end()) continue;  // closed since it sent the request
+        Connection& conn = *it->second;
+
+        conn.tx.insert(conn.tx.end(), report.frame, report.frame + report.length);
+        if (!conn.dirty) {
+            conn.dirty = true;
+            dirty_.push_back(&conn);
+        }
+    }
+    return drained;
+}
+
+void Gateway::flush_dirty() {
+    // flush() may drop a slow client, so collect first and close afterwards
+    std::vector<uint32_t> dead;
+    for (Connection* conn : dirty_) {
+        conn->dirty = false;
+        if (!flush(*conn)) dead.push_back(conn->session);
+    }
+    dirty_.clear();
+    for (uint32_t session : dead) close_session(session);
+}
+
+bool Gateway::flush(Connection& conn) {
+    while (conn.tx_sent < conn.tx.size()) {
+        ssize_t sent = ::send(conn.fd, conn.tx.data() + conn.tx_sent, conn.tx.size() - conn.tx_sent, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+            if (conn.tx.size() - conn.tx_sent > options_.max_backlog) return false;
+            if (!conn.writing) {
+                epoll_event ev{};
+                ev.events   = EPOLLIN | EPOLLOUT;
+                ev.data.u64 = conn.session;
+                epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &ev);
+                conn.writing = true;
+            }
+            return true;
+        }
+        conn.tx_sent += (size_t)sent;
+    }
+
+    conn.tx.clear();
+    conn.tx_sent = 0;
+    if (conn.writing) {
+        epoll_event ev{};
+        ev.events   = EPOLLIN;
+        ev.data.u64 = conn.session;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &ev);
+        conn.writing = false;
+    }
+    return true;
+}
+
+void Gateway::close_session(uint32_t session) {
+    auto it = sessions_.find(session);
+    if (it == sessions_.end()) return;
+
+    Connection* conn = it->second.get();
+    if (conn->dirty) dirty_.erase(std::find(dirty_.begin(), dirty_.end(), conn));
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn->fd, nullptr);
+    ::close(conn->fd);
+    sessions_.erase(it);
+
+    // queued behind the session's last requests, so nothing it sent survives
+    if (options_.cancel_on_disconnect) {
+        Request request{};
+        request.session    = session;
+        request.disconnect = true;
+        enqueue(request);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Matching thread
+
+void Gateway::run_matching() {
+    Request  request;
+    Backoff  backoff;
+    unsigned idle = 0;
+
+    // reading_done_ is checked before the ring, so a request pushed just
+    // before the I/O thread stopped is still seen
+    for (;;) {
+        bool last = reading_done_.load(std::memory_order_acquire);
+        if (inbound_.try_pop(request)) {
+            backoff.reset();
+            idle = 0;
+            process(request);
+            continue;
+        }
+        if (last) break;
+        if (++idle < options_.spin_polls) {
+            backoff.pause();
+            continue;
+        }
+
+        // park; the flag goes up before the last look at the ring so a
+        // request pushed in between is either seen here or rings the bell
+        match_parked_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (inbound_.empty() && !reading_done_.load(std::memory_order_acquire)) {
+            uint64_t rings;
+            ssize_t  rc = ::read(match_bell_, &rings, sizeof(rings));
+            (void)rc;
+        }
+        match_parked_.store(false, std::memory_order_relaxed);
+        idle = 0;
+    }
+    matching_done_.store(true, std::memory_order_release);
+}
+
+void Gateway::process(const Request& request) {
+    const Order& order = request.order;
+
+    if (request.disconnect) {
+        engine_.mass_cancel(CancelFilter::owned_by(request.session));
+        // still ACKed, to balance in_flight_; the I/O thread drops it with the session
+        AckMsg ack{};
+        ack.header = MsgHeader{sizeof(AckMsg), MsgType::ACK, 0};
+        report(request.session, &ack, sizeof(ack));
+        return;
+    }
+
+    AckMsg ack{};
+    ack.header          = MsgHeader{sizeof(AckMsg), MsgType::ACK, 0};
+    ack.instrument      = request.instrument;
+    ack.client_order_id = request.client_order_id;
+    ack.sent_at         = request.sent_at;
+    ack.request         = order.type == OrderType::CANCEL ? MsgType::CANCEL
+                        : order.type == OrderType::MODIFY ? MsgType::MODIFY : MsgType::NEW_ORDER;
+    ack.status          = AckStatus::ACCEPTED;
+
+    // both sides of a fill go back to their owners; session 0 is not a client
+    auto on_trade = [&](const Trade& trade) {
+        for (Side side : {Side::BUY, Side::SELL}) {
+            uint64_t order_id = side == Side::BUY ? trade.buy_order_id : trade.sell_order_id;
+            uint32_t session  = owner_of(order_id);
+            if (session == 0) continue;
+
+            FillMsg fill{};
+            fill.header          = MsgHeader{sizeof(FillMsg), MsgType::FILL, 0};
+            fill.instrument      = request.instrument;
+            fill.client_order_id = order_id & CLIENT_ID_MASK;
+            fill.price           = trade.price;
+            fill.quantity        = trade.quantity;
+            fill.side            = (uint8_t)side;
+            report(session, &fill, sizeof(fill));
+        }
+    };
+
+    if (request.client_order_id > CLIENT_ID_MASK) {
+        ack.status = AckStatus::BAD_ORDER_ID;
+    } else if (request.instrument >= instruments_) {
+        ack.status = AckStatus::UNKNOWN_INSTRUMENT;
+    } else {
+        try {
+            switch (order.type) {
+                case OrderType::CANCEL:
+                    if (!engine_.cancel(request.instrument, order.order_id)) ack.status = AckStatus::UNKNOWN_ORDER;
+                    break;
+                case OrderType::MODIFY:
+                    if (!engine_.modify(request.instrument, order.order_id, order.price, order.quantity, on_trade))
+                        ack.status = AckStatus::UNKNOWN_ORDER;
+                    break;
+                default: {
+                    RiskResult risk = engine_.submit(request.instrument, order, on_trade);
+                    if (risk != RiskResult::ACCEPTED) {
+                        ack.status = AckStatus::RISK_REJECTED;
+                        ack.risk   = (uint8_t)risk;
+                    }
+                }
+            }
+        } catch (const std::out_of_range&) {
+            ack.status = AckStatus::BAD_PRICE;
+        }
+    }
+
+    report(request.session, &ack, sizeof(ack));
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (io_parked_.load(std::memory_order_relaxed)) ring(io_bell_);
+}
+
+void Gateway::report(uint32_t session, const void* frame, uint16_t length) {
+    Report report;
+    report.session = session;
+    report.length  = length;
+    std::memcpy(report.frame, frame, length);
+
+    Backoff backoff;
+    while (!outbound_.try_push(report)) {
+        if (io_parked_.load(std::memory_order_relaxed)) ring(io_bell_);
+        backoff.pause();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// GatewayClient
+
+GatewayClient::GatewayClient(const std::string& unix_path) : rx_(RX_BUFFER) {
+    sockaddr_un addr = unix_address(unix_path);
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd_ < 0) throw sys_error("socket");
+    if (::connect(fd_, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        ::close(fd_);
+        throw sys_error("connect " + unix_path);
+    }
+}
+
+GatewayClient::GatewayClient(const std::string& host, int port) : rx_(RX_BUFFER) {
+    addrinfo hints{};
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found   = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &found) != 0 || !found)
+        throw std::runtime_error("cannot resolve " + host);
+
+    fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    int rc = fd_ < 0 ? -1 : ::connect(fd_, found->ai_addr, found->ai_addrlen);
+    freeaddrinfo(found);
+    if (rc != 0) {
+        if (fd_ >= 0) ::close(fd_);
+        throw sys_error("connect " + host + ":" + std::to_string(port));
+    }
+
+    int on = 1;
+    setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
+
+GatewayClient::~GatewayClient() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+void GatewayClient::append(const void* frame, size_t length) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(frame);
+    tx_.insert(tx_.end(), bytes, bytes + length);
+}
+
+void GatewayClient::new_order(InstrumentId instrument, uint64_t client_order_id, const Order& order,
+                              uint64_t sent_at) {
+    NewOrderMsg msg{};
+    msg.header           = MsgHeader{sizeof(NewOrderMsg), MsgType::NEW_ORDER, 0};
+    msg.instrument       = instrument;
+    msg.client_order_id  = client_order_id;
+    msg.price            = order.price;
+    msg.quantity         = order.quantity;
+    msg.display_quantity = order.display_quantity;
+    msg.sent_at          = sent_at;
+    msg.account          = order.account;
+    msg.side             = (uint8_t)order.side;
+    msg.type             = (uint8_t)order.type;
+    msg.tif              = (uint8_t)order.tif;
+    msg.post_only        = order.post_only;
+    append(&msg, sizeof(msg));
+}
+
+void GatewayClient::cancel(InstrumentId instrument, uint64_t client_order_id, uint64_t sent_at) {
+    CancelMsg msg{};
+    msg.header          = MsgHeader{sizeof(CancelMsg), MsgType::CANCEL, 0};
+    msg.instrument      = instrument;
+    msg.client_order_id = client_order_id;
+    msg.sent_at         = sent_at;
+    append(&msg, sizeof(msg));
+}
+
+void GatewayClient::modify(InstrumentId instrument, uint64_t client_order_id, Price price, uint64_t quantity,
+                           uint64_t sent_at) {
+    ModifyMsg msg{};
+    msg.header          = MsgHeader{sizeof(ModifyMsg), MsgType::MODIFY, 0};
+    msg.instrument      = instrument;
+    msg.client_order_id = client_order_id;
+    msg.price           = price;
+    msg.quantity        = quantity;
+    msg.sent_at         = sent_at;
+    append(&msg, sizeof(msg));
+}
+
+void GatewayClient::flush() {
+    size_t sent = 0;
+    while (sent < tx_.size()) {
+        ssize_t n = ::send(fd_, tx_.data() + sent, tx_.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw sys_error("gateway send");
+        }
+        sent += (size_t)n;
+    }
+    tx_.clear();
+}
+
+bool GatewayClient::read_some(bool wait) {
+    for (;;) {
+        ssize_t got = ::recv(fd_, rx_.data() + rx_len_, rx_.size() - rx_len_, wait ? 0 : MSG_DONTWAIT);
+        if (got > 0) {
+            rx_len_ += (size_t)got;
+            return true;
+        }
+        if (got == 0) throw std::runtime_error("gateway closed the connection");
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return false;
+        throw sys_error("gateway recv");
+    }
+}
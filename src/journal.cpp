@@ -0,0 +1,238 @@
+#include "../include/journal.hpp"
+#include "../include/engine.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char     JOURNAL_MAGIC[8] = {'O', 'B', 'J', 'R', 'N', 'L', '\0', '\1'};
+static const uint32_t JOURNAL_VERSION  = 3;  // bumped whenever the record set or layout changes
+
+static std::runtime_error sys_error(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+JournalWriter::JournalWriter(const std::string& path, JournalOptions options)
+    : options_(options) {
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) throw sys_error("cannot open journal", path);
+
+    if (options_.batch_records == 0) options_.batch_records = 1;
+    buffer_.reserve(options_.batch_records);
+
+    JournalHeader header{};
+    std::memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+    header.version     = JOURNAL_VERSION;
+    header.record_size = sizeof(JournalRecord);
+    write_all(&header, sizeof(header));
+}
+
+JournalWriter::~JournalWriter() {
+    if (fd_ < 0) return;
+    try { flush(); } catch (...) {}
+    ::close(fd_);
+}
+
+void JournalWriter::append_symbol(InstrumentId id, const std::string& symbol,
+                                  const InstrumentConfig& config, BookMode mode) {
+    JournalRecord record{};
+    if (symbol.size() >= sizeof(record.symbol.name))
+        throw std::invalid_argument("symbol too long for journal: " + symbol);
+
+    record.type       = JournalRecordType::SYMBOL;
+    record.instrument = id;
+    std::memcpy(record.symbol.name, symbol.data(), symbol.size());
+    record.symbol.mode      = (uint32_t)mode;
+    record.symbol.tick_size = config.tick_size;
+    record.symbol.min_price = config.min_price;
+    record.symbol.max_price = config.max_price;
+    append(record);
+}
+
+void JournalWriter::append_order(InstrumentId id, const Order& order) {
+    JournalRecord record{};
+    record.type                   = JournalRecordType::ORDER;
+    record.instrument             = id;
+    record.order.order_id         = order.order_id;
+    record.order.timestamp        = order.timestamp;
+    record.order.price            = order.price;
+    record.order.quantity         = order.quantity;
+    record.order.side             = (uint8_t)order.side;
+    record.order.type             = (uint8_t)order.type;
+    record.order.tif              = (uint8_t)order.tif;
+    record.order.post_only        = order.post_only;
+    record.order.display_quantity = order.display_quantity;
+    record.order.account          = order.account;
+    append(record);
+}
+
+void JournalWriter::append_mass_cancel(InstrumentId id, const CancelFilter& filter) {
+    JournalRecord record{};
+    record.type             = JournalRecordType::MASS_CANCEL;
+    record.instrument       = id;
+    record.cancel.min_price = filter.min_price;
+    record.cancel.max_price = filter.max_price;
+    record.cancel.owner     = filter.owner;
+    record.cancel.bids      = filter.bids;
+    record.cancel.asks      = filter.asks;
+    record.cancel.by_owner  = filter.by_owner;
+    append(record);
+}
+
+void JournalWriter::append_auction(InstrumentId id, JournalAuction action, const AuctionOptions& options) {
+    JournalRecord record{};
+    record.type                   = JournalRecordType::AUCTION;
+    record.instrument             = id;
+    record.auction.reference      = options.reference.value_or(0);
+    record.auction.indicate_every = options.indicate_every;
+    record.auction.action         = (uint8_t)action;
+    record.auction.has_reference  = options.reference.has_value();
+    append(record);
+}
+
+void JournalWriter::append(const JournalRecord& record) {
+    buffer_.push_back(record);
+    buffer_.back().sequence = sequence_++;
+
+    if (options_.sync == SyncPolicy::EVERY || buffer_.size() >= options_.batch_records)
+        flush();
+}
+
+void JournalWriter::flush() {
+    if (!buffer_.empty()) {
+        write_all(buffer_.data(), buffer_.size() * sizeof(JournalRecord));
+        buffer_.clear();
+    }
+    if (options_.sync != SyncPolicy::NONE && ::fdatasync(fd_) != 0)
+        throw std::runtime_error(std::string("journal fdatasync failed: ") + std::strerror(errno));
+}
+
+void JournalWriter::write_all(const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = ::write(fd_, p, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("journal write failed: ") + std::strerror(errno));
+        }
+        p    += n;
+        size -= (size_t)n;
+    }
+}
+
+JournalReader::JournalReader(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw sys_error("cannot open journal", path);
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw sys_error("cannot stat journal", path);
+    }
+    length_ = (size_t)st.st_size;
+
+    if (length_ < sizeof(JournalHeader)) {
+        ::close(fd);
+        throw std::runtime_error("journal too short: " + path);
+    }
+
+    mapping_ = ::mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        throw sys_error("cannot mmap journal", path);
+    }
+    ::madvise(mapping_, length_, MADV_SEQUENTIAL);
+    ::madvise(mapping_, length_, MADV_WILLNEED);
+
+    const auto* header = static_cast<const JournalHeader*>(mapping_);
+    if (std::memcmp(header->magic, JOURNAL_MAGIC, sizeof(header->magic)) != 0
+        || header->version != JOURNAL_VERSION
+        || header->record_size != sizeof(JournalRecord)) {
+        ::munmap(mapping_, length_);
+        mapping_ = nullptr;
+        throw std::runtime_error("not a journal or unsupported version: " + path);
+    }
+
+    // a torn final record from a crash mid-write is ignored
+    records_ = reinterpret_cast<const JournalRecord*>(header + 1);
+    count_   = (length_ - sizeof(JournalHeader)) / sizeof(JournalRecord);
+}
+
+JournalReader::~JournalReader() {
+    if (mapping_) ::munmap(mapping_, length_);
+}
+
+Order journal_order(const JournalRecord& record) {
+    return Order{
+        .order_id         = record.order.order_id,
+        .price            = record.order.price,
+        .quantity         = record.order.quantity,
+        .account          = record.order.account,
+        .side             = (Side)record.order.side,
+        .type             = (OrderType)record.order.type,
+        .tif              = (TimeInForce)record.order.tif,
+        .post_only        = record.order.post_only != 0,
+        .display_quantity = record.order.display_quantity,
+        .timestamp        = record.order.timestamp
+    };
+}
+
+size_t replay(const JournalReader& journal, Engine& engine, TradeSink on_trade,
+              uint64_t from_sequence) {
+    std::vector<InstrumentId> ids;  // journal id -> engine id
+    size_t orders = 0;
+
+    for (const JournalRecord& record : journal) {
+        if (record.type == JournalRecordType::SYMBOL) {
+            std::string name(record.symbol.name, strnlen(record.symbol.name, sizeof(record.symbol.name)));
+            InstrumentConfig config{record.symbol.tick_size, record.symbol.min_price, record.symbol.max_price};
+            BookMode mode = (BookMode)record.symbol.mode;
+
+            if (mode == BookMode::LADDER) engine.add_symbol(name, config, mode);
+            if (ids.size() <= record.instrument) ids.resize(record.instrument + 1);
+            ids[record.instrument] = engine.intern(name);
+            continue;
+        }
+        if (record.sequence < from_sequence) continue;
+
+        apply_record(record, engine, ids[record.instrument], on_trade);
+        ++orders;
+    }
+    return orders;
+}
+
+void apply_record(const JournalRecord& record, Engine& engine, InstrumentId id, TradeSink on_trade) {
+    if (record.type == JournalRecordType::MASS_CANCEL) {
+        CancelFilter filter;
+        filter.bids      = record.cancel.bids != 0;
+        filter.asks      = record.cancel.asks != 0;
+        filter.min_price = record.cancel.min_price;
+        filter.max_price = record.cancel.max_price;
+        filter.by_owner  = record.cancel.by_owner != 0;
+        filter.owner     = record.cancel.owner;
+        engine.mass_cancel(id, filter);
+        return;
+    }
+
+    if (record.type == JournalRecordType::AUCTION) {
+        if ((JournalAuction)record.auction.action == JournalAuction::BEGIN) {
+            AuctionOptions options;
+            if (record.auction.has_reference) options.reference = record.auction.reference;
+            options.indicate_every = record.auction.indicate_every;
+            engine.begin_auction(id, options);
+        } else {
+            engine.uncross(id, on_trade);
+        }
+        return;
+    }
+
+    if (record.type != JournalRecordType::ORDER)
+        throw std::runtime_error("unknown journal record type " + std::to_string((uint32_t)record.type));
+
+    engine.submit(id, journal_order(record), on_trade);
+}
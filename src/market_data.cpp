@@ -0,0 +1,7 @@
+#include "../include/market_data.hpp"
+
+void ConflatingPublisher::on_level(const LevelUpdate& update) {
+    auto [it, inserted] = index_[(int)update.side].try_emplace(update.price, pending_.size());
+    if (inserted) pending_.push_back(update);
+    else          pending_[it->second].quantity = update.quantity;
+}
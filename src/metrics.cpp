@@ -0,0 +1,106 @@
+#include "../include/metrics.hpp"
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+
+double tsc_ticks_per_ns() {
+    static const double ratio = [] {
+        using clock = std::chrono::steady_clock;
+        auto     t0 = clock::now();
+        uint64_t c0 = tsc_now();
+        while (clock::now() - t0 < std::chrono::milliseconds(20)) {}
+        uint64_t c1 = tsc_now();
+        auto     ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - t0).count();
+        return (double)(c1 - c0) / (double)ns;
+    }();
+    return ratio;
+}
+
+uint64_t Histogram::highest_in(size_t index) {
+    if (index < LINEAR_LIMIT) return index;
+    size_t   shift = (index - LINEAR_LIMIT) / SUB_BUCKETS + 1;
+    uint64_t sub   = (index - LINEAR_LIMIT) % SUB_BUCKETS + SUB_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+}
+
+HistogramSnapshot Histogram::snapshot() const {
+    HistogramSnapshot out;
+    out.counts.resize(BUCKETS);
+    for (size_t i = 0; i < BUCKETS; i++) out.counts[i] = counts_[i].load(std::memory_order_relaxed);
+    out.total = total_.load(std::memory_order_relaxed);
+    out.sum   = sum_.load(std::memory_order_relaxed);
+    out.max   = max_.load(std::memory_order_relaxed);
+    return out;
+}
+
+uint64_t HistogramSnapshot::percentile(double p) const {
+    // count from the buckets, not total: a concurrent snapshot can see them disagree
+    uint64_t recorded = 0;
+    for (uint64_t c : counts) recorded += c;
+    if (recorded == 0) return 0;
+
+    uint64_t rank = (uint64_t)std::ceil(p / 100.0 * (double)recorded);
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            uint64_t value = Histogram::highest_in(i);
+            return value < max ? value : max;
+        }
+    }
+    return max;
+}
+
+const char* to_string(Stage stage) {
+    switch (stage) {
+        case Stage::LOOKUP: return "lookup";
+        case Stage::SUBMIT: return "submit";
+        case Stage::MATCH:  return "match";
+        case Stage::REST:   return "rest";
+        case Stage::CANCEL: return "cancel";
+        case Stage::COUNT:  break;
+    }
+    return "unknown";
+}
+
+EngineMetrics::EngineMetrics(unsigned sample_shift)
+    : sample_mask_((uint64_t(1) << sample_shift) - 1) {
+    tsc_ticks_per_ns();
+}
+
+MetricsReport EngineMetrics::report() const {
+    MetricsReport out;
+    for (size_t i = 0; i < stages.size(); i++) out.stages[i] = stages[i].snapshot();
+    out.fills_per_order = fills_per_order.snapshot();
+    out.levels_touched  = levels_touched.snapshot();
+    out.book_depth      = book_depth.snapshot();
+    out.ticks_per_ns    = tsc_ticks_per_ns();
+    return out;
+}
+
+void MetricsReport::print(std::ostream& out) const {
+    auto ns = [&](uint64_t ticks) { return (uint64_t)std::llround((double)ticks / ticks_per_ns); };
+
+    out << "  stage       count       p50       p99     p99.9       max   (ns)\n";
+    for (size_t i = 0; i < stages.size(); i++) {
+        const HistogramSnapshot& h = stages[i];
+        if (h.total == 0) continue;
+        out << "  " << std::left << std::setw(8) << to_string((Stage)i) << std::right
+            << std::setw(10) << h.total
+            << std::setw(10) << ns(h.percentile(50))
+            << std::setw(10) << ns(h.percentile(99))
+            << std::setw(10) << ns(h.percentile(99.9))
+            << std::setw(10) << ns(h.max) << "\n";
+    }
+
+    auto counter = [&](const char* name, const HistogramSnapshot& h) {
+        out << "  " << std::left << std::setw(16) << name << std::right
+            << "mean " << std::fixed << std::setprecision(2) << h.mean()
+            << "  p99 " << h.percentile(99) << "  max " << h.max << "\n";
+    };
+    counter("fills/order", fills_per_order);
+    counter("levels touched", levels_touched);
+    counter("book depth", book_depth);
+}
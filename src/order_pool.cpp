@@ -0,0 +1,39 @@
+#include "../include/order_pool.hpp"
+
+OrderPool::OrderPool(size_t slab_size) : slab_size_(slab_size) {}
+
+OrderNode* OrderPool::acquire(const Order& order) {
+    if (!free_list_) add_slab();
+
+    OrderNode* node = free_list_;
+    free_list_ = node->next;
+
+    node->order   = order;
+    node->prev    = nullptr;
+    node->next    = nullptr;
+    node->level   = nullptr;
+    node->reserve = 0;
+    ++in_use_;
+    return node;
+}
+
+void OrderPool::release(OrderNode* node) {
+    node->next = free_list_;
+    free_list_ = node;
+    --in_use_;
+}
+
+void OrderPool::reserve(size_t n) {
+    while (capacity() < n) add_slab();
+}
+
+void OrderPool::add_slab() {
+    slabs_.push_back(std::make_unique<OrderNode[]>(slab_size_));
+    OrderNode* slab = slabs_.back().get();
+
+    // push in reverse so nodes come off the free list in address order
+    for (size_t i = slab_size_; i-- > 0;) {
+        slab[i].next = free_list_;
+        free_list_   = &slab[i];
+    }
+}
@@ -1,95 +1,846 @@
 #include "../include/orderbook.hpp"
+#include "../include/risk.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+OrderBook::OrderBook(OrderPool* pool)
+    : own_pool_(pool ? nullptr : std::make_unique<OrderPool>()),
+      pool_(pool ? pool : own_pool_.get()) {}
+
+OrderBook::OrderBook(BookMode mode, const InstrumentConfig& config, OrderPool* pool)
+    : OrderBook(pool) {
+    mode_   = mode;
+    config_ = config;
+    if (mode_ == BookMode::LADDER) {
+        bid_ladder_ = PriceLadder<Side::BUY>(config_);
+        ask_ladder_ = PriceLadder<Side::SELL>(config_);
+    }
+}
 
 std::vector<Trade> OrderBook::submit(Order order) {
+    std::vector<Trade> trades;
+    submit(order, [&](const Trade& trade) { trades.push_back(trade); });
+    return trades;
+}
+
+void OrderBook::validate(const Order& order) const {
+    if (mode_ != BookMode::LADDER) return;
+    switch (order.type) {
+        case OrderType::LIMIT:
+            if (!config_.is_valid_price(order.price))
+                throw std::out_of_range("limit price outside instrument band or off tick");
+            break;
+        case OrderType::MODIFY:
+            if (order.quantity != 0 && !config_.is_valid_price(order.price))
+                throw std::out_of_range("modify price outside instrument band or off tick");
+            break;
+        case OrderType::STOP:
+        case OrderType::STOP_LIMIT:
+            if (!config_.is_valid_price(order.stop_price))
+                throw std::out_of_range("stop price outside instrument band or off tick");
+            if (order.type == OrderType::STOP_LIMIT && !config_.is_valid_price(order.price))
+                throw std::out_of_range("limit price outside instrument band or off tick");
+            break;
+        default:
+            break;
+    }
+}
+
+void OrderBook::submit(Order order, TradeSink on_trade) {
     if (order.type == OrderType::CANCEL) {
         cancel(order.order_id);
-        return {};
+        return;
     }
-    if (order.type == OrderType::MARKET)
-        return match_market(order);
+    validate(order);
 
-    return match_limit(order);
-}
+    if (order.type == OrderType::MODIFY) {
+        modify(order.order_id, order.price, order.quantity, on_trade);
+        return;
+    }
 
-std::vector<Trade> OrderBook::match_limit(Order& order) {
-    std::vector<Trade> trades;
+    if (is_stop(order.type)) {
+        add_stop(order);
+        return;
+    }
+
+    if (auction_) {
+        queue_for_auction(order);
+        return;
+    }
 
-    if (order.side == Side::BUY)
-        trades = run_matching_loop(order, asks_);
-    else
-        trades = run_matching_loop(order, bids_);
+    match(order, on_trade);
+    if (!elected_.empty()) run_elected(on_trade);
+}
 
-    if (order.quantity > 0) {
+void OrderBook::match(Order& order, TradeSink& on_trade) {
+    // the only branch on side and type; everything below is specialised
+    const bool market = (order.type == OrderType::MARKET);
+    with_sides([&](auto& bids, auto& asks) {
         if (order.side == Side::BUY) {
-            bids_[order.price].add_order(order);
+            if (market) execute<Side::BUY, OrderType::MARKET>(order, bids, asks, on_trade);
+            else        execute<Side::BUY, OrderType::LIMIT>(order, bids, asks, on_trade);
         } else {
-            asks_[order.price].add_order(order);
+            if (market) execute<Side::SELL, OrderType::MARKET>(order, asks, bids, on_trade);
+            else        execute<Side::SELL, OrderType::LIMIT>(order, asks, bids, on_trade);
         }
-        order_map_[order.order_id] = {order.price, order.side};
+    });
+}
+
+void OrderBook::add_stop(const Order& order) {
+    OrderNode* node = pool_->acquire(order);
+    if (order.side == Side::BUY) buy_stops_.level_at(order.stop_price).add_order(node);
+    else                         sell_stops_.level_at(order.stop_price).add_order(node);
+    order_index_.insert(order.order_id, node);
+    ++stop_count_;
+}
+
+void OrderBook::cancel_stop(OrderNode* node) {
+    PriceLevel* level = node->level;
+    level->cancel_order(node);
+    if (level->is_empty()) {
+        if (node->order.side == Side::BUY) buy_stops_.erase(node->order.stop_price);
+        else                               sell_stops_.erase(node->order.stop_price);
     }
+    release(node->order, node->order.quantity);
+    pool_->release(node);
+    --stop_count_;
+}
 
-    return trades;
+void OrderBook::elect_stops(Price low, Price high) {
+    // the best trigger is the nearest, so the range scan stops at the first
+    // level the prints did not reach
+    auto elect = [&](auto& stops, Price print) {
+        while (!stops.empty() && stops.within(stops.best_key(), print)) {
+            stops.best_level().remove_if([](const Order&) { return true; }, [&](OrderNode* node, uint32_t) {
+                Order order            = node->order;
+                order.type             = (order.type == OrderType::STOP) ? OrderType::MARKET : OrderType::LIMIT;
+                order.display_quantity = 0;
+                elected_.push_back(order);
+                order_index_.erase(order.order_id);
+                pool_->release(node);
+                --stop_count_;
+            });
+            stops.pop_best();
+        }
+    };
+    elect(buy_stops_, high);
+    elect(sell_stops_, low);
+}
+
+void OrderBook::run_elected(TradeSink& on_trade) {
+    // an elected order's own prints may elect more, which land behind it
+    for (size_t i = 0; i < elected_.size(); i++) {
+        Order order = elected_[i];
+        match(order, on_trade);
+    }
+    elected_.clear();
 }
 
-std::vector<Trade> OrderBook::match_market(Order& order) {
-    if (order.side == Side::BUY)
-        return run_matching_loop(order, asks_);
-    else
-        return run_matching_loop(order, bids_);
+void OrderBook::begin_auction(const AuctionOptions& options) {
+    if (auction_market_.empty()) auction_market_.resize(2);
+    auction_         = true;
+    auction_options_ = options;
+    auction_changes_ = 0;
+    published_       = AuctionIndication{};
 }
 
-bool OrderBook::cancel(uint64_t order_id) {
-    auto loc = order_map_.find(order_id);
-    if (loc == order_map_.end()) return false;
-
-    double price = loc->second.price;
-    Side   side  = loc->second.side;
-
-    if (side == Side::BUY) {
-        auto level_it = bids_.find(price);
-        if (level_it != bids_.end()) {
-            level_it->second.cancel_order(order_id);
-            if (level_it->second.is_empty())
-                bids_.erase(level_it);
+void OrderBook::queue_for_auction(const Order& order) {
+    if (order.tif != TimeInForce::GTC) {  // IOC and FOK cannot wait for the uncross
+        release(order, order.quantity);
+        return;
+    }
+
+    OrderNode* node;
+    if (order.type == OrderType::MARKET) {
+        node = pool_->acquire(order);
+        auction_market_[(int)order.side].add_order(node);
+    } else {
+        node = with_sides([&](auto& bids, auto& asks) {
+            return order.side == Side::BUY ? rest(order, bids) : rest(order, asks);
+        });
+    }
+    order_index_.insert(order.order_id, node);
+    auction_changed();
+}
+
+void OrderBook::cancel_auction_market(OrderNode* node) {
+    node->level->cancel_order(node);
+    release(node->order, node->order.quantity);
+    pool_->release(node);
+}
+
+void OrderBook::auction_changed() {
+    if (!listener_ || ++auction_changes_ < auction_options_.indicate_every) return;
+    auction_changes_ = 0;
+
+    AuctionIndication now = compute_uncross();
+    if (now.price == published_.price && now.volume == published_.volume &&
+        now.imbalance == published_.imbalance) return;
+    published_ = now;
+    listener_->on_auction(now);
+}
+
+AuctionIndication OrderBook::indicative() const {
+    return auction_ ? compute_uncross() : AuctionIndication{};
+}
+
+AuctionIndication OrderBook::compute_uncross() const {
+    AuctionLadder& l = ladder_;
+    const uint64_t market_buys  = auction_market_[(int)Side::BUY].total_quantity();
+    const uint64_t market_sells = auction_market_[(int)Side::SELL].total_quantity();
+
+    // Only levels that can trade count: bids down to the lowest ask and asks
+    // up to the highest bid, or the whole side when market orders face it.
+    l.bid_levels.clear();
+    l.ask_levels.clear();
+    with_sides([&](const auto& bids, const auto& asks) {
+        if ((bids.empty() && market_buys == 0) || (asks.empty() && market_sells == 0)) return;
+        const Price lo = (market_sells > 0 || asks.empty()) ? std::numeric_limits<Price>::min()
+                                                            : asks.price_of(asks.best_key());
+        const Price hi = (market_buys > 0 || bids.empty()) ? std::numeric_limits<Price>::max()
+                                                           : bids.price_of(bids.best_key());
+        auto collect = [](const auto& book_side, auto&& in_range, std::vector<DepthLevel>& out) {
+            book_side.for_each_level([&](auto key, const PriceLevel& level) {
+                Price price = book_side.price_of(key);
+                if (!in_range(price)) return false;
+                out.push_back(DepthLevel{price, level.total_quantity() + level.reserve_quantity()});
+                return true;
+            });
+        };
+        collect(bids, [&](Price price) { return price >= lo; }, l.bid_levels);
+        collect(asks, [&](Price price) { return price <= hi; }, l.ask_levels);
+    });
+
+    // merge into one ascending price axis: bids were walked high to low
+    l.price.clear();
+    l.bids.clear();
+    l.asks.clear();
+    size_t b = l.bid_levels.size(), a = 0;
+    while (b > 0 || a < l.ask_levels.size()) {
+        const bool take_bid = b > 0 && (a == l.ask_levels.size() || l.bid_levels[b - 1].price <= l.ask_levels[a].price);
+        const bool take_ask = a < l.ask_levels.size() && (b == 0 || l.ask_levels[a].price <= l.bid_levels[b - 1].price);
+        l.price.push_back(take_bid ? l.bid_levels[b - 1].price : l.ask_levels[a].price);
+        l.bids.push_back(take_bid ? l.bid_levels[--b].quantity : 0);
+        l.asks.push_back(take_ask ? l.ask_levels[a++].quantity : 0);
+    }
+
+    const size_t n = l.price.size();
+    if (n == 0) return AuctionIndication{};
+
+    // cumulative depth: sellers at or below each price, buyers at or above it
+    uint64_t sum = market_sells;
+    for (size_t i = 0; i < n; i++) l.asks[i] = (sum += l.asks[i]);
+    sum = market_buys;
+    for (size_t i = n; i-- > 0;) l.bids[i] = (sum += l.bids[i]);
+
+    l.volume.resize(n);
+    l.surplus.resize(n);
+    uint64_t best_volume = 0;
+    for (size_t i = 0; i < n; i++) {
+        l.volume[i]  = std::min(l.bids[i], l.asks[i]);
+        l.surplus[i] = std::max(l.bids[i], l.asks[i]) - l.volume[i];
+        best_volume  = std::max(best_volume, l.volume[i]);
+    }
+    if (best_volume == 0) return AuctionIndication{};
+
+    uint64_t best_surplus = std::numeric_limits<uint64_t>::max();
+    for (size_t i = 0; i < n; i++)
+        best_surplus = std::min(best_surplus, l.volume[i] == best_volume ? l.surplus[i]
+                                                                        : std::numeric_limits<uint64_t>::max());
+
+    // the candidates left are few; settle the pressure and reference rules on them
+    const size_t none = n;
+    size_t first = none, last = none, nearest = none;
+    bool   buyers_over = true, sellers_over = true;
+    Price  distance = std::numeric_limits<Price>::max();
+    for (size_t i = 0; i < n; i++) {
+        if (l.volume[i] != best_volume || l.surplus[i] != best_surplus) continue;
+        if (first == none) first = i;
+        last          = i;
+        buyers_over  &= l.bids[i] > l.asks[i];
+        sellers_over &= l.bids[i] < l.asks[i];
+        if (auction_options_.reference) {
+            Price d = l.price[i] > *auction_options_.reference ? l.price[i] - *auction_options_.reference
+                                                               : *auction_options_.reference - l.price[i];
+            if (d < distance) {
+                distance = d;
+                nearest  = i;
+            }
         }
+    }
+
+    size_t pick = first;
+    if (buyers_over)                     pick = last;
+    else if (sellers_over)               pick = first;
+    else if (auction_options_.reference) pick = nearest;
+
+    return AuctionIndication{l.price[pick], best_volume, (int64_t)l.bids[pick] - (int64_t)l.asks[pick]};
+}
+
+AuctionIndication OrderBook::uncross(TradeSink on_trade) {
+    if (!auction_) return AuctionIndication{};
+
+    const AuctionIndication at = compute_uncross();
+    if (at.volume > 0) {
+        with_sides([&](auto& bids, auto& asks) { execute_uncross(at, bids, asks, on_trade); });
+    }
+
+    // market orders the uncross did not reach do not carry into continuous trading
+    for (PriceLevel& level : auction_market_) {
+        level.remove_if([](const Order&) { return true; }, [&](OrderNode* node, uint32_t) {
+            order_index_.erase(node->order.order_id);
+            release(node->order, node->order.quantity);
+            pool_->release(node);
+        });
+    }
+    auction_ = false;
+
+    if (at.volume > 0 && stop_count_ > 0) elect_stops(at.price, at.price);
+    if (!elected_.empty()) run_elected(on_trade);
+    return at;
+}
+
+template<typename Bids, typename Asks>
+void OrderBook::execute_uncross(const AuctionIndication& at, Bids& bids, Asks& asks, TradeSink& on_trade) {
+    PriceLevel& market_buys  = auction_market_[(int)Side::BUY];
+    PriceLevel& market_sells = auction_market_[(int)Side::SELL];
+
+    // the next order on a side in priority: market orders, then levels best
+    // first as far as the uncross price
+    auto next = [&](PriceLevel& market, auto& book_side, auto&& reaches) -> PriceLevel* {
+        if (!market.is_empty()) return &market;
+        if (!book_side.empty() && reaches(book_side.price_of(book_side.best_key()))) return &book_side.best_level();
+        return nullptr;
+    };
+
+    // takes qty off the front order of a side; market orders publish nothing
+    auto fill = [&](PriceLevel& level, PriceLevel& market, auto& book_side, Side side, uint64_t qty) {
+        const bool   in_book = (&level != &market);
+        const Price  price   = in_book ? book_side.price_of(book_side.best_key()) : at.price;
+        const Order& front   = level.head()->order;
+        uint64_t     id      = front.order_id;
+
+        OrderNode* filled = level.fill_front(qty);
+        if (in_book) {
+            order_event(OrderEventType::EXECUTE, front, price, qty, 0);
+            level_changed(price, side, level);
+        }
+        if (filled && filled->reserve > 0) {
+            level.replenish(filled);
+            if (in_book) notify_add(filled, price);
+        } else if (filled) {
+            order_index_.erase(id);
+            pool_->release(filled);
+            if (in_book && level.is_empty()) book_side.pop_best();
+        }
+    };
+
+    // both sides hold at least `volume` within the price, so neither runs dry
+    uint64_t left = at.volume;
+    while (left > 0) {
+        PriceLevel* buy  = next(market_buys, bids, [&](Price price) { return price >= at.price; });
+        PriceLevel* sell = next(market_sells, asks, [&](Price price) { return price <= at.price; });
+        const Order& buyer  = buy->head()->order;
+        const Order& seller = sell->head()->order;
+        uint64_t     qty    = std::min({left, buyer.quantity, seller.quantity});
+
+        on_trade(Trade{
+            .buy_order_id  = buyer.order_id,
+            .sell_order_id = seller.order_id,
+            .price         = at.price,
+            .quantity      = qty,
+            .buy_account   = buyer.account,
+            .sell_account  = seller.account
+        });
+        left -= qty;
+
+        fill(*buy, market_buys, bids, Side::BUY, qty);
+        fill(*sell, market_sells, asks, Side::SELL, qty);
+    }
+}
+
+// An iceberg node arrives holding its full quantity; keep one slice shown.
+static void split_iceberg(OrderNode* node) {
+    uint64_t peak = node->order.display_quantity;
+    if (peak == 0 || node->order.quantity <= peak) return;
+    node->reserve        = node->order.quantity - peak;
+    node->order.quantity = peak;
+}
+
+template<typename SideBook>
+OrderNode* OrderBook::rest(const Order& order, SideBook& own_side) {
+    OrderNode* node = pool_->acquire(order);
+    split_iceberg(node);
+    queue(node, own_side);
+    return node;
+}
+
+template<typename SideBook>
+void OrderBook::queue(OrderNode* node, SideBook& own_side) {
+    auto key = own_side.key_of(node->order.price);
+    own_side.level_at(key).add_order(node);
+    notify_add(node, own_side.price_of(key));
+}
+
+void OrderBook::notify_add(const OrderNode* node, Price price) {
+    if (!listener_) return;
+    const PriceLevel& level = *node->level;
+    order_event(OrderEventType::ADD, node->order, price, node->order.quantity,
+                level.order_count() - 1);
+    level_changed(price, node->order.side, level);
+}
+
+void OrderBook::notify_delete(const Order& order, Price price, uint64_t removed,
+                              uint32_t position, const PriceLevel& level) {
+    if (!listener_) return;
+    Order gone    = order;
+    gone.quantity = 0;
+    order_event(OrderEventType::DELETE, gone, price, removed, position);
+    level_changed(price, order.side, level);
+}
+
+void OrderBook::release(const Order& order, uint64_t quantity) {
+    if (risk_ && quantity > 0) risk_->on_release(order, quantity);
+}
+
+template<Side S, OrderType T, typename OwnSide, typename PassiveSide>
+void OrderBook::execute(Order& order, OwnSide& own_side, PassiveSide& passive_side,
+                        TradeSink& on_trade) {
+    // both checks run before the first fill, so a rejected order never trades
+    if ((order.post_only && crosses<T>(order, passive_side)) ||
+        (order.tif == TimeInForce::FOK && !fillable<T>(order, passive_side))) {
+        release(order, order.quantity);
+        return;
+    }
+
+    const bool timed = metrics_ && metrics_->sample(Stage::MATCH);
+    uint64_t   t0    = timed ? tsc_now() : 0;
+    run_matching_loop<S, T>(order, passive_side, on_trade);
+    if (timed) {
+        uint64_t t1 = tsc_now();
+        metrics_->record(Stage::MATCH, t1 - t0);
+        t0 = t1;
+    }
+
+    bool rested = false;
+    if constexpr (T == OrderType::LIMIT) {
+        if (order.tif == TimeInForce::GTC && order.quantity > 0) {
+            order_index_.insert(order.order_id, rest(order, own_side));
+            if (timed) metrics_->record(Stage::REST, tsc_now() - t0);
+            rested = true;
+        }
+    }
+    if (!rested) release(order, order.quantity);  // IOC, FOK or market remainder
+
+    if (metrics_) metrics_->book_depth.record(own_side.level_count() + passive_side.level_count());
+}
+
+template<OrderType T, typename SideBook>
+bool OrderBook::crosses(const Order& order, const SideBook& passive_side) const {
+    if (passive_side.empty()) return false;
+    if constexpr (T == OrderType::MARKET) return true;
+    return SideBook::within(passive_side.best_key(), passive_side.key_of(order.price));
+}
+
+template<OrderType T, typename SideBook>
+bool OrderBook::fillable(const Order& order, const SideBook& passive_side) const {
+    constexpr bool is_market = (T == OrderType::MARKET);
+    const auto     limit     = passive_side.key_of(order.price);
+    uint64_t   available = 0;
+
+    passive_side.for_each_level([&](auto key, const PriceLevel& level) {
+        if (!is_market && !SideBook::within(key, limit)) return false;
+        available += level.total_quantity() + level.reserve_quantity();
+        return available < order.quantity;
+    });
+    return available >= order.quantity;
+}
+
+void OrderBook::restore_order(const Order& order, uint64_t reserve) {
+    if (is_stop(order.type)) {
+        add_stop(order);
+        return;
+    }
+    with_sides([&](auto& bids, auto& asks) {
+        OrderNode* node = pool_->acquire(order);
+        node->reserve   = reserve;
+        if (order.side == Side::BUY) queue(node, bids);
+        else                         queue(node, asks);
+        order_index_.insert(order.order_id, node);
+    });
+}
+
+bool OrderBook::cancel(uint64_t order_id) {
+    const bool timed = metrics_ && metrics_->sample(Stage::CANCEL);
+    uint64_t   t0    = timed ? tsc_now() : 0;
+
+    OrderNode* node = order_index_.find(order_id);
+    if (!node) {
+        if (timed) metrics_->record(Stage::CANCEL, tsc_now() - t0);
+        return false;
+    }
+
+    order_index_.erase(order_id);
+    if (is_stop(node->order.type)) {
+        cancel_stop(node);
+    } else if (node->order.type == OrderType::MARKET) {
+        cancel_auction_market(node);
     } else {
-        auto level_it = asks_.find(price);
-        if (level_it != asks_.end()) {
-            level_it->second.cancel_order(order_id);
-            if (level_it->second.is_empty())
-                asks_.erase(level_it);
+        with_sides([&](auto& bids, auto& asks) {
+            if (node->order.side == Side::BUY) cancel_in(node, bids);
+            else                               cancel_in(node, asks);
+        });
+    }
+    if (auction_) auction_changed();
+    if (timed) metrics_->record(Stage::CANCEL, tsc_now() - t0);
+    return true;
+}
+
+template<typename SideBook>
+void OrderBook::cancel_in(OrderNode* node, SideBook& own_side) {
+    PriceLevel* level    = node->level;
+    uint32_t    position = listener_ ? level->position_of(node) : 0;
+    uint64_t    removed  = node->order.quantity;
+    release(node->order, removed + node->reserve);
+    level->cancel_order(node);
+
+    // the side container is only touched when the level goes away
+    auto key = own_side.key_of(node->order.price);
+    notify_delete(node->order, own_side.price_of(key), removed, position, *level);
+    if (level->is_empty()) own_side.erase(key);
+
+    pool_->release(node);
+}
+
+static bool unbounded(const CancelFilter& filter) {
+    return filter.min_price == std::numeric_limits<Price>::min() &&
+           filter.max_price == std::numeric_limits<Price>::max();
+}
+
+// side and price, a stop's trigger for a stop; a market order queued in a call
+// has no price and only goes when the range is open. The owner tag is checked
+// by the caller.
+static bool selects(const CancelFilter& filter, const Order& order) {
+    if (!(order.side == Side::BUY ? filter.bids : filter.asks)) return false;
+    if (order.type == OrderType::MARKET) return unbounded(filter);
+    Price price = is_stop(order.type) ? order.stop_price : order.price;
+    return price >= filter.min_price && price <= filter.max_price;
+}
+
+MassCancelReport OrderBook::mass_cancel(const CancelFilter& filter) {
+    MassCancelReport report;
+    if (filter.min_price > filter.max_price) return report;
+
+    // everything goes: skip the per-order index erase and sweep the table once
+    const bool whole_book = filter.bids && filter.asks && !filter.by_owner && unbounded(filter);
+    with_sides([&](auto& bids, auto& asks) {
+        if (whole_book && !listener_) {
+            // nobody needs per-order events: free the nodes straight from the
+            // index slots, whose addresses are all known up front, instead of
+            // chasing each level's links one miss at a time
+            order_index_.for_each([&](uint64_t, OrderNode* node) {
+                report.quantity += node->order.quantity + node->reserve;
+                release(node->order, node->order.quantity + node->reserve);
+                pool_->release(node);
+            });
+            report.orders = order_index_.size();
+            auto forget = [&](auto, PriceLevel& level) {
+                level.reset();
+                report.levels += 1;
+            };
+            bids.drain(filter.min_price, filter.max_price, forget);
+            asks.drain(filter.min_price, filter.max_price, forget);
+            auto forget_stops = [](Price, PriceLevel& level) { level.reset(); };
+            buy_stops_.drain(filter.min_price, filter.max_price, forget_stops);
+            sell_stops_.drain(filter.min_price, filter.max_price, forget_stops);
+            stop_count_ = 0;
+            for (PriceLevel& level : auction_market_) level.reset();
+            return;
+        }
+        if (filter.by_owner && !listener_) {
+            // an owner's orders can sit anywhere, but the tag is in the key:
+            // sweep the index and only touch the nodes that may go
+            order_index_.erase_if(
+                [&](uint64_t order_id, const OrderNode& node) {
+                    return owner_of(order_id) == filter.owner && selects(filter, node.order);
+                },
+                [&](OrderNode* node) {
+                    if (is_stop(node->order.type) || node->order.type == OrderType::MARKET) {
+                        report.orders   += 1;
+                        report.quantity += node->order.quantity;
+                        if (is_stop(node->order.type)) cancel_stop(node);
+                        else                           cancel_auction_market(node);
+                    } else if (node->order.side == Side::BUY) {
+                        unlink_mass_cancelled(node, bids, report);
+                    } else {
+                        unlink_mass_cancelled(node, asks, report);
+                    }
+                });
+            return;
+        }
+        if (filter.bids) mass_cancel_in(bids, Side::BUY, filter, !whole_book, report);
+        if (filter.asks) mass_cancel_in(asks, Side::SELL, filter, !whole_book, report);
+        if (filter.bids) mass_cancel_stops(buy_stops_, filter, !whole_book, report);
+        if (filter.asks) mass_cancel_stops(sell_stops_, filter, !whole_book, report);
+        if (!auction_market_.empty() && unbounded(filter)) {
+            for (Side side : {Side::BUY, Side::SELL}) {
+                if (!(side == Side::BUY ? filter.bids : filter.asks)) continue;
+                auction_market_[(int)side].remove_if(
+                    [&](const Order& order) { return !filter.by_owner || owner_of(order.order_id) == filter.owner; },
+                    [&](OrderNode* node, uint32_t) {
+                        report.orders   += 1;
+                        report.quantity += node->order.quantity;
+                        if (!whole_book) order_index_.erase(node->order.order_id);
+                        release(node->order, node->order.quantity);
+                        pool_->release(node);
+                    });
+            }
+        }
+    });
+    if (whole_book) order_index_.clear();
+    if (auction_ && report.orders > 0) auction_changed();
+    return report;
+}
+
+template<typename SideBook>
+void OrderBook::mass_cancel_in(SideBook& own_side, Side side, const CancelFilter& filter, bool unindex,
+                               MassCancelReport& report) {
+    own_side.drain(filter.min_price, filter.max_price, [&](auto key, PriceLevel& level) {
+        const Price    price   = own_side.price_of(key);
+        const uint64_t removed = report.orders;
+
+        level.remove_if(
+            [&](const Order& order) { return !filter.by_owner || owner_of(order.order_id) == filter.owner; },
+            [&](OrderNode* node, uint32_t position) {
+                report.orders   += 1;
+                report.quantity += node->order.quantity + node->reserve;
+                if (unindex) order_index_.erase(node->order.order_id);
+                if (listener_) {
+                    Order gone    = node->order;
+                    gone.quantity = 0;
+                    order_event(OrderEventType::DELETE, gone, price, node->order.quantity, position);
+                }
+                release(node->order, node->order.quantity + node->reserve);
+                pool_->release(node);
+            });
+
+        if (report.orders != removed) level_changed(price, side, level);
+        report.levels += level.is_empty();
+    });
+}
+
+// waiting stops were never published, so they go without events and their
+// trigger levels are not counted as price levels
+template<typename StopTree>
+void OrderBook::mass_cancel_stops(StopTree& stops, const CancelFilter& filter, bool unindex,
+                                  MassCancelReport& report) {
+    stops.drain(filter.min_price, filter.max_price, [&](Price, PriceLevel& level) {
+        level.remove_if(
+            [&](const Order& order) { return !filter.by_owner || owner_of(order.order_id) == filter.owner; },
+            [&](OrderNode* node, uint32_t) {
+                report.orders   += 1;
+                report.quantity += node->order.quantity;
+                if (unindex) order_index_.erase(node->order.order_id);
+                release(node->order, node->order.quantity);
+                pool_->release(node);
+                --stop_count_;
+            });
+    });
+}
+
+template<typename SideBook>
+void OrderBook::unlink_mass_cancelled(OrderNode* node, SideBook& own_side, MassCancelReport& report) {
+    PriceLevel* level = node->level;
+    report.orders   += 1;
+    report.quantity += node->order.quantity + node->reserve;
+    release(node->order, node->order.quantity + node->reserve);
+    level->cancel_order(node);
+    if (level->is_empty()) {
+        own_side.erase(own_side.key_of(node->order.price));
+        report.levels += 1;
+    }
+    pool_->release(node);
+}
+
+bool OrderBook::modify(uint64_t order_id, Price price, uint64_t quantity, TradeSink on_trade) {
+    if (quantity == 0) return cancel(order_id);
+
+    // a market order queued in a call has no price to amend
+    OrderNode* node = order_index_.find(order_id);
+    if (!node || is_stop(node->order.type) || node->order.type == OrderType::MARKET) return false;
+
+    if (mode_ == BookMode::LADDER && !config_.is_valid_price(price)) {
+        throw std::out_of_range("modify price outside instrument band or off tick");
+    }
+
+    bool applied = with_sides([&](auto& bids, auto& asks) {
+        if (node->order.side == Side::BUY) return modify_in<Side::BUY>(node, price, quantity, bids, asks, on_trade);
+        else                               return modify_in<Side::SELL>(node, price, quantity, asks, bids, on_trade);
+    });
+    if (!applied) return false;
+    if (!elected_.empty()) run_elected(on_trade);
+    if (auction_) auction_changed();
+    return true;
+}
+
+template<Side S, typename OwnSide, typename PassiveSide>
+bool OrderBook::modify_in(OrderNode* node, Price price, uint64_t quantity,
+                          OwnSide& own_side, PassiveSide& passive_side, TradeSink& on_trade) {
+    Order&      order     = node->order;
+    PriceLevel* level     = node->level;
+    auto        old_key   = own_side.key_of(order.price);
+    auto        new_key   = own_side.key_of(price);
+    Price       old_price = own_side.price_of(old_key);
+    uint32_t    position  = listener_ ? level->position_of(node) : 0;
+
+    uint64_t    total     = order.quantity + node->reserve;  // shown + hidden
+
+    if (new_key == old_key) {
+        if (quantity == total) return true;
+
+        // a cut at the same price is the only amend that keeps time priority;
+        // an iceberg gives up hidden quantity first, which nobody can see
+        if (quantity < total) {
+            release(order, total - quantity);
+            if (quantity >= order.quantity) {
+                level->reduce_reserve(node, quantity - order.quantity);
+                return true;
+            }
+            level->reduce_reserve(node, 0);
+            uint64_t removed = order.quantity - quantity;
+            level->reduce_order(node, quantity);
+            order_event(OrderEventType::MODIFY, order, old_price, removed, position);
+            level_changed(old_price, order.side, *level);
+            return true;
+        }
+
+        // an increase requeues at the back; the level itself never empties
+        uint64_t removed = order.quantity;
+        level->cancel_order(node);
+        notify_delete(order, old_price, removed, position, *level);
+        order.quantity = quantity;
+        node->reserve  = 0;
+        split_iceberg(node);
+        level->add_order(node);
+        notify_add(node, old_price);
+        return true;
+    }
+
+    // a post-only order may not take liquidity on an amend either: one that
+    // would cross is refused and keeps its place, as execute() drops a new one
+    if (order.post_only && !auction_) {
+        Order moved = order;
+        moved.price = price;
+        if (crosses<OrderType::LIMIT>(moved, passive_side)) {
+            if (quantity > total) release(moved, quantity - total);  // the increase risk took on
+            return false;
         }
     }
 
-    order_map_.erase(loc);
+    // new price: leave the old level, match as an aggressor (not during a
+    // call), rest the remainder
+    uint64_t removed = order.quantity;
+    level->cancel_order(node);
+    notify_delete(order, old_price, removed, position, *level);
+    if (level->is_empty()) own_side.erase(old_key);
+
+    if (quantity < total) release(order, total - quantity);
+    order.price    = price;
+    order.quantity = quantity;
+    node->reserve  = 0;
+    if (!auction_) run_matching_loop<S, OrderType::LIMIT>(order, passive_side, on_trade);
+
+    if (order.quantity == 0) {
+        order_index_.erase(order.order_id);
+        pool_->release(node);
+        return true;
+    }
+    split_iceberg(node);
+    queue(node, own_side);
     return true;
 }
 
-std::optional<double> OrderBook::best_bid() const {
-    if (bids_.empty()) return std::nullopt;
-    return bids_.begin()->first;
+std::optional<Price> OrderBook::best_bid() const {
+    return with_sides([](const auto& bids, const auto&) -> std::optional<Price> {
+        if (bids.empty()) return std::nullopt;
+        return bids.price_of(bids.best_key());
+    });
 }
 
-std::optional<double> OrderBook::best_ask() const {
-    if (asks_.empty()) return std::nullopt;
-    return asks_.begin()->first;
+std::optional<Price> OrderBook::best_ask() const {
+    return with_sides([](const auto&, const auto& asks) -> std::optional<Price> {
+        if (asks.empty()) return std::nullopt;
+        return asks.price_of(asks.best_key());
+    });
 }
 
-std::optional<double> OrderBook::spread() const {
+std::optional<Price> OrderBook::spread() const {
     auto bid = best_bid();
     auto ask = best_ask();
     if (!bid || !ask) return std::nullopt;
     return *ask - *bid;
 }
 
-uint32_t OrderBook::bid_quantity_at(double price) const {
-    auto it = bids_.find(price);
-    if (it == bids_.end()) return 0;
-    return it->second.total_quantity();
+void OrderBook::prefetch(const Order& order) const {
+    with_sides([&](const auto& bids, const auto& asks) {
+        if (order.side == Side::BUY) {
+            asks.prefetch_best();
+            bids.prefetch(bids.key_of(order.price));
+        } else {
+            bids.prefetch_best();
+            asks.prefetch(asks.key_of(order.price));
+        }
+    });
+}
+
+size_t OrderBook::depth(Side side, DepthLevel* out, size_t n) const {
+    size_t count = 0;
+    if (n == 0) return 0;
+    with_sides([&](const auto& bids, const auto& asks) {
+        auto collect = [&](const auto& book_side) {
+            book_side.for_each_level([&](auto key, const PriceLevel& level) {
+                out[count++] = DepthLevel{book_side.price_of(key), level.total_quantity()};
+                return count < n;
+            });
+        };
+        if (side == Side::BUY) collect(bids);
+        else                   collect(asks);
+    });
+    return count;
+}
+
+std::vector<DepthLevel> OrderBook::depth(Side side, size_t n) const {
+    std::vector<DepthLevel> levels(n);
+    levels.resize(depth(side, levels.data(), n));
+    return levels;
 }
 
-uint32_t OrderBook::ask_quantity_at(double price) const {
-    auto it = asks_.find(price);
-    if (it == asks_.end()) return 0;
-    return it->second.total_quantity();
-}
\ No newline at end of file
+MemoryUsage OrderBook::memory() const {
+    MemoryUsage usage;
+    usage.orders      = order_index_.size();
+    usage.node_bytes  = usage.orders * sizeof(OrderNode);
+    usage.index_bytes = order_index_.memory_bytes();
+    usage.level_bytes = with_sides([](const auto& bids, const auto& asks) {
+        return bids.memory_bytes() + asks.memory_bytes();
+    }) + buy_stops_.memory_bytes() + sell_stops_.memory_bytes();
+    return usage;
+}
+
+// a ladder key truncates to the tick below, so an off-grid price is checked
+// here rather than answered with its neighbour's quantity
+uint64_t OrderBook::bid_quantity_at(Price price) const {
+    if (mode_ == BookMode::LADDER && !config_.is_valid_price(price)) return 0;
+    return with_sides([&](const auto& bids, const auto&) -> uint64_t {
+        const PriceLevel* level = bids.find(bids.key_of(price));
+        return level ? level->total_quantity() : 0;
+    });
+}
+
+uint64_t OrderBook::ask_quantity_at(Price price) const {
+    if (mode_ == BookMode::LADDER && !config_.is_valid_price(price)) return 0;
+    return with_sides([&](const auto&, const auto& asks) -> uint64_t {
+        const PriceLevel* level = asks.find(asks.key_of(price));
+        return level ? level->total_quantity() : 0;
+    });
+}
@@ -1,44 +1,89 @@
 #include "../include/price_level.hpp"  // relative path up one folder
 #include <cstdint>
-#include <iterator>
 #include <stdexcept>
 
-void PriceLevel::add_order(const Order& order){
-    orders_.push_back(order);
-    index_[order.order_id] = std::prev(orders_.end());
-    total_qty_ += order.quantity;
+void PriceLevel::add_order(OrderNode* node){
+    node->level = this;
+    node->prev  = tail_;
+    node->next  = nullptr;
+
+    if (tail_) tail_->next = node;
+    else       head_ = node;
+    tail_ = node;
+
+    total_qty_   += node->order.quantity;
+    reserve_qty_ += node->reserve;
+    ++count_;
+}
+
+void PriceLevel::cancel_order(OrderNode* node) {
+    total_qty_   -= node->order.quantity;
+    reserve_qty_ -= node->reserve;
+    unlink(node); // O(1), no lookup
 }
 
-void PriceLevel::cancel_order(uint64_t order_id) {
-    auto it = index_.find(order_id);
-    if(it == index_.end()) return;
+void PriceLevel::reduce_order(OrderNode* node, uint64_t new_quantity) {
+    total_qty_ -= node->order.quantity - new_quantity;
+    node->order.quantity = new_quantity;
+}
 
-    total_qty_ -= it->second->quantity;
-    orders_.erase(it->second); // O(1)
-    index_.erase(it); // clean indx too
+void PriceLevel::reduce_reserve(OrderNode* node, uint64_t new_reserve) {
+    reserve_qty_ -= node->reserve - new_reserve;
+    node->reserve = new_reserve;
 }
 
-void PriceLevel::fill_front(uint32_t filled_quantity){
-    Order& front = orders_.front();
-    front.quantity -= filled_quantity;
+OrderNode* PriceLevel::fill_front(uint64_t filled_quantity){
+    OrderNode* front = head_;
+    front->order.quantity -= filled_quantity;
     total_qty_ -= filled_quantity;
 
-    if(front.quantity == 0) {
-        index_.erase(front.order_id);
-        orders_.pop_front();
+    if(front->order.quantity == 0) {
+        reserve_qty_ -= front->reserve;
+        unlink(front);
+        return front;
     }
+    return nullptr;
+}
+
+void PriceLevel::replenish(OrderNode* node) {
+    uint64_t slice = node->order.display_quantity;
+    if (slice > node->reserve) slice = node->reserve;
+
+    node->order.quantity = slice;
+    node->reserve       -= slice;
+    add_order(node);  // time priority restarts with every slice
 }
+
 const Order& PriceLevel::get_front() const {
-    if (orders_.empty()) {
+    if (!head_) {
         throw std::runtime_error("get_front() called on empty PriceLevel");
     }
-    return orders_.front();
+    return head_->order;
+}
+
+uint32_t PriceLevel::position_of(const OrderNode* node) const {
+    uint32_t position = 0;
+    for (const OrderNode* n = node->prev; n; n = n->prev) ++position;
+    return position;
 }
 
 bool PriceLevel::is_empty() const {
-    return orders_.empty();
+    return head_ == nullptr;
 }
 
-uint32_t PriceLevel::total_quantity() const {
+uint64_t PriceLevel::total_quantity() const {
     return total_qty_;
-}
\ No newline at end of file
+}
+
+void PriceLevel::unlink(OrderNode* node) {
+    if (node->prev) node->prev->next = node->next;
+    else            head_ = node->next;
+
+    if (node->next) node->next->prev = node->prev;
+    else            tail_ = node->prev;
+
+    node->prev  = nullptr;
+    node->next  = nullptr;
+    node->level = nullptr;
+    --count_;
+}
@@ -0,0 +1,14 @@
+#include "../include/risk.hpp"
+
+const char* to_string(RiskResult result) {
+    switch (result) {
+        case RiskResult::ACCEPTED:        return "accepted";
+        case RiskResult::UNKNOWN_ACCOUNT: return "unknown account";
+        case RiskResult::MAX_QUANTITY:    return "max order quantity";
+        case RiskResult::PRICE_COLLAR:    return "price collar";
+        case RiskResult::POSITION_LIMIT:  return "position limit";
+        case RiskResult::NOTIONAL_LIMIT:  return "notional limit";
+        case RiskResult::RATE_LIMIT:      return "message rate";
+    }
+    return "unknown";
+}
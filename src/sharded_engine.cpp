@@ -0,0 +1,127 @@
+#include "../include/sharded_engine.hpp"
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+
+ShardedEngine::ShardedEngine(size_t num_shards, size_t queue_capacity, int first_core)
+    : first_core_(first_core) {
+    for (size_t i = 0; i < num_shards; i++)
+        shards_.push_back(std::make_unique<Shard>(queue_capacity));
+}
+
+ShardedEngine::~ShardedEngine() {
+    stop();
+}
+
+InstrumentId ShardedEngine::add_symbol(const std::string& symbol) {
+    if (auto id = symbols_.find(symbol)) return *id;
+    Shard& shard = *shards_[symbols_.size() % shards_.size()];
+    return route(symbol, shard, shard.engine.intern(symbol));
+}
+
+InstrumentId ShardedEngine::add_symbol(const std::string& symbol, const InstrumentConfig& config,
+                                       BookMode mode) {
+    if (auto id = symbols_.find(symbol)) return *id;
+    Shard& shard = *shards_[symbols_.size() % shards_.size()];
+    shard.engine.add_symbol(symbol, config, mode);
+    return route(symbol, shard, *shard.engine.find_symbol(symbol));
+}
+
+InstrumentId ShardedEngine::route(const std::string& symbol, Shard& shard, InstrumentId local) {
+    InstrumentId id = symbols_.intern(symbol);
+    uint32_t     index = (uint32_t)(id % shards_.size());
+
+    routes_.push_back(Route{index, local});
+    if (shard.global_ids.size() <= local) shard.global_ids.resize(local + 1);
+    shard.global_ids[local] = id;
+    return id;
+}
+
+std::optional<InstrumentId> ShardedEngine::find_symbol(const std::string& symbol) const {
+    return symbols_.find(symbol);
+}
+
+void ShardedEngine::start() {
+    if (running_.exchange(true)) return;
+
+    unsigned cores = std::thread::hardware_concurrency();
+    for (size_t i = 0; i < shards_.size(); i++) {
+        Shard& shard = *shards_[i];
+        shard.thread = std::thread([this, &shard] { run(shard); });
+
+        if (first_core_ >= 0 && cores > 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET((first_core_ + i) % cores, &set);
+            pthread_setaffinity_np(shard.thread.native_handle(), sizeof(set), &set);
+        }
+    }
+}
+
+void ShardedEngine::stop() {
+    if (!running_.exchange(false)) return;
+    for (auto& shard : shards_)
+        if (shard->thread.joinable()) shard->thread.join();
+}
+
+void ShardedEngine::set_risk(size_t shard, PreTradeRisk* risk) {
+    shards_[shard]->engine.set_risk(risk);
+}
+
+void ShardedEngine::set_metrics(size_t shard, EngineMetrics* metrics) {
+    shards_[shard]->engine.set_metrics(metrics);
+}
+
+void ShardedEngine::submit(InstrumentId id, const Order& order) {
+    const Route& r = routes_[id];
+    OrderMessage msg{r.local, order};
+
+    Backoff backoff;
+    while (!shards_[r.shard]->inbound.try_push(msg)) backoff.pause();
+}
+
+void ShardedEngine::cancel(InstrumentId id, uint64_t order_id) {
+    Order order{};
+    order.order_id = order_id;
+    order.type     = OrderType::CANCEL;
+    submit(id, order);
+}
+
+void ShardedEngine::modify(InstrumentId id, uint64_t order_id, Price price, uint64_t quantity) {
+    Order order{};
+    order.order_id = order_id;
+    order.price    = price;
+    order.quantity = quantity;
+    order.type     = OrderType::MODIFY;
+    submit(id, order);
+}
+
+void ShardedEngine::run(Shard& shard) {
+    OrderMessage msg;
+    Backoff      backoff;
+
+    // keep draining after stop() so nothing already queued is dropped
+    while (running_.load(std::memory_order_acquire) || !shard.inbound.empty()) {
+        if (!shard.inbound.try_pop(msg)) {
+            backoff.pause();
+            continue;
+        }
+        backoff.reset();
+
+        InstrumentId global = shard.global_ids[msg.instrument];
+        auto send = [&](const ExecutionReport& report) {
+            Backoff full;
+            while (!shard.outbound.try_push(report)) full.pause();
+        };
+        // a bad price must not escape the shard thread and terminate the process
+        try {
+            RiskResult verdict = shard.engine.submit(msg.instrument, msg.order, [&](const Trade& trade) {
+                send(ExecutionReport{global, ReportType::FILL, RiskResult::ACCEPTED, 0, trade});
+            });
+            if (verdict != RiskResult::ACCEPTED)
+                send(ExecutionReport{global, ReportType::REJECT, verdict, msg.order.order_id, Trade{}});
+        } catch (const std::out_of_range&) {
+            send(ExecutionReport{global, ReportType::REJECT, RiskResult::ACCEPTED, msg.order.order_id, Trade{}});
+        }
+    }
+}
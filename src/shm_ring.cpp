@@ -0,0 +1,315 @@
+#include "../include/shm_ring.hpp"
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static const char     SHM_MAGIC[8] = {'O', 'B', 'S', 'H', 'M', '\0', '\0', '\1'};
+static const uint32_t SHM_VERSION  = 1;
+
+static std::runtime_error sys_error(const std::string& what, const std::string& name) {
+    return std::runtime_error(what + " " + name + ": " + std::strerror(errno));
+}
+
+static uint32_t round_up_pow2(uint32_t n) {
+    uint32_t size = 2;
+    while (size < n) size <<= 1;
+    return size;
+}
+
+static size_t region_size(uint32_t order_slots, uint32_t event_slots) {
+    return sizeof(ShmHeader) + order_slots * sizeof(ShmOrderSlot) + event_slots * sizeof(ShmEventSlot);
+}
+
+void shm_futex_wait(std::atomic<uint32_t>& word, uint32_t expected) {
+    // returns at once if the word already moved on; spurious wake-ups are fine
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, nullptr, nullptr, 0);
+}
+
+void shm_futex_wake(std::atomic<uint32_t>& word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// ---------------------------------------------------------------------------
+// ShmChannel
+
+ShmChannel::ShmChannel(const std::string& name, bool create, const ShmOptions& options)
+    : name_(name), owner_(create) {
+    int fd = shm_open(name.c_str(), create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0600);
+    if (fd < 0) throw sys_error("cannot open shared memory", name);
+
+    uint32_t order_slots = round_up_pow2(options.order_slots);
+    uint32_t event_slots = round_up_pow2(options.event_slots);
+
+    if (create) {
+        size_ = region_size(order_slots, event_slots);
+        if (ftruncate(fd, (off_t)size_) != 0) {
+            ::close(fd);
+            shm_unlink(name.c_str());
+            throw sys_error("cannot size shared memory", name);
+        }
+    } else {
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ShmHeader)) {
+            ::close(fd);
+            throw std::runtime_error("shared memory too small: " + name);
+        }
+        size_ = (size_t)st.st_size;
+    }
+
+    // MAP_POPULATE: fault every page in now rather than on the first orders
+    base_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (base_ == MAP_FAILED) {
+        if (create) shm_unlink(name.c_str());
+        throw sys_error("cannot mmap shared memory", name);
+    }
+
+    header_ = static_cast<ShmHeader*>(base_);
+    if (create) {
+        new (header_) ShmHeader{};
+        header_->version     = SHM_VERSION;
+        header_->order_slots = order_slots;
+        header_->event_slots = event_slots;
+    } else {
+        order_slots = header_->order_slots;
+        event_slots = header_->event_slots;
+        if (std::memcmp(header_->magic, SHM_MAGIC, sizeof(SHM_MAGIC)) != 0 || header_->version != SHM_VERSION ||
+            size_ < region_size(order_slots, event_slots)) {
+            munmap(base_, size_);
+            throw std::runtime_error("not an order channel or unsupported version: " + name);
+        }
+    }
+
+    orders_ = reinterpret_cast<ShmOrderSlot*>(static_cast<char*>(base_) + sizeof(ShmHeader));
+    events_ = reinterpret_cast<ShmEventSlot*>(orders_ + order_slots);
+
+    if (create) {
+        for (uint32_t i = 0; i < order_slots; i++) new (&orders_[i]) ShmOrderSlot{{i}, 0, {}, 0};
+        for (uint32_t i = 0; i < event_slots; i++) new (&events_[i]) ShmEventSlot{};
+        // the magic goes in last, so an attaching process never sees a half-built ring
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(header_->magic, SHM_MAGIC, sizeof(SHM_MAGIC));
+    }
+}
+
+ShmChannel::~ShmChannel() {
+    if (base_ && base_ != MAP_FAILED) munmap(base_, size_);
+    if (owner_) shm_unlink(name_.c_str());
+}
+
+// ---------------------------------------------------------------------------
+// ShmGateway
+
+class ShmGateway::LevelPublisher : public BookListener {
+public:
+    LevelPublisher(ShmGateway& gateway, InstrumentId instrument)
+        : gateway_(gateway), instrument_(instrument) {}
+
+    void on_level(const LevelUpdate& update) override {
+        ShmEvent event{};
+        event.type       = ShmEventType::LEVEL;
+        event.instrument = instrument_;
+        event.level      = update;
+        gateway_.publish(event);
+    }
+
+private:
+    ShmGateway&  gateway_;
+    InstrumentId instrument_;
+};
+
+ShmGateway::ShmGateway(Engine& engine, const std::string& name, ShmOptions options)
+    : engine_(engine), options_(options), channel_(name, true, options) {}
+
+ShmGateway::~ShmGateway() {
+    stop();
+}
+
+void ShmGateway::start(int core) {
+    if (running_.exchange(true)) return;
+
+    if (options_.level_updates) {
+        for (InstrumentId id = 0; id < engine_.instrument_count(); id++) {
+            publishers_.push_back(std::make_unique<LevelPublisher>(*this, id));
+            engine_.set_listener(id, publishers_.back().get());
+        }
+    }
+
+    thread_ = std::thread([this] { run(); });
+
+    unsigned cores = std::thread::hardware_concurrency();
+    if (core >= 0 && cores > 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core % cores, &set);
+        pthread_setaffinity_np(thread_.native_handle(), sizeof(set), &set);
+    }
+}
+
+void ShmGateway::stop() {
+    if (!running_.exchange(false)) return;
+
+    ShmHeader& h = channel_.header();
+    h.order_futex.fetch_add(1, std::memory_order_seq_cst);
+    shm_futex_wake(h.order_futex);
+    if (thread_.joinable()) thread_.join();
+
+    for (InstrumentId id = 0; id < publishers_.size(); id++) engine_.set_listener(id, nullptr);
+    publishers_.clear();
+}
+
+bool ShmGateway::try_pop(OrderMessage& out, uint64_t& sent_tsc) {
+    ShmHeader&    h    = channel_.header();
+    const uint64_t mask = h.order_slots - 1;
+    uint64_t      pos  = h.order_head.load(std::memory_order_relaxed);
+    ShmOrderSlot& slot = channel_.orders()[pos & mask];
+
+    if ((int32_t)(slot.sequence.load(std::memory_order_acquire) - (uint32_t)(pos + 1)) < 0) return false;
+
+    out.instrument = slot.instrument;
+    out.order      = slot.order;
+    sent_tsc       = slot.sent_tsc;
+    slot.sequence.store((uint32_t)(pos + mask + 1), std::memory_order_release);
+    h.order_head.store(pos + 1, std::memory_order_relaxed);
+    return true;
+}
+
+void ShmGateway::run() {
+    ShmHeader&   h = channel_.header();
+    const size_t instruments = engine_.instrument_count();
+
+    OrderMessage msg;
+    uint64_t     sent_tsc;
+    unsigned     idle = 0;
+
+    auto on_trade = [&](const Trade& trade) {
+        ShmEvent event{};
+        event.type       = ShmEventType::TRADE;
+        event.instrument = msg.instrument;
+        event.trade      = trade;
+        publish(event);
+    };
+    TradeSink sink = on_trade;
+
+    // after stop() keep going until the ring is empty
+    for (;;) {
+        bool last = !running_.load(std::memory_order_acquire);
+        if (try_pop(msg, sent_tsc)) {
+            if (latency_) latency_->record(tsc_now() - sent_tsc);
+            idle = 0;
+
+            if (msg.instrument >= instruments) {
+                reject(msg.instrument, msg.order.order_id, RiskResult::ACCEPTED);
+            } else {
+                try {
+                    RiskResult verdict = engine_.submit(msg.instrument, msg.order, sink);
+                    if (verdict != RiskResult::ACCEPTED) reject(msg.instrument, msg.order.order_id, verdict);
+                } catch (const std::out_of_range&) {
+                    reject(msg.instrument, msg.order.order_id, RiskResult::ACCEPTED);
+                }
+            }
+            wake_readers();
+            processed_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (last) break;
+
+        if (options_.wait == ShmWait::SPIN || ++idle < options_.spin_polls) {
+            cpu_relax();
+            continue;
+        }
+
+        // sleep; a producer that stores after our flag sees it and bumps the word
+        uint32_t seen = h.order_futex.load(std::memory_order_relaxed);
+        h.order_sleeping.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        const uint64_t head = h.order_head.load(std::memory_order_relaxed);
+        const ShmOrderSlot& next = channel_.orders()[head & (h.order_slots - 1)];
+        bool ready = (int32_t)(next.sequence.load(std::memory_order_acquire) - (uint32_t)(head + 1)) >= 0;
+        if (!ready && running_.load(std::memory_order_acquire)) shm_futex_wait(h.order_futex, seen);
+
+        h.order_sleeping.store(0, std::memory_order_relaxed);
+        idle = 0;
+    }
+}
+
+void ShmGateway::publish(ShmEvent& event) {
+    ShmHeader&    h    = channel_.header();
+    ShmEventSlot& slot = channel_.events()[next_event_ & (h.event_slots - 1)];
+
+    // seqlock write: readers that see 0 or a changed sequence retry or skip
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.sent_tsc = tsc_now();
+    std::memcpy(&slot.event, &event, sizeof(event));
+    slot.sequence.store((uint32_t)(next_event_ + 1), std::memory_order_release);
+
+    h.event_tail.store(++next_event_, std::memory_order_release);
+}
+
+void ShmGateway::reject(InstrumentId instrument, uint64_t order_id, RiskResult risk) {
+    ShmEvent event{};
+    event.type       = ShmEventType::REJECT;
+    event.risk       = risk;
+    event.instrument = instrument;
+    event.order_id   = order_id;
+    publish(event);
+}
+
+// once per inbound message rather than per event: one fence covers every
+// event the message produced
+void ShmGateway::wake_readers() {
+    ShmHeader& h = channel_.header();
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (h.event_sleepers.load(std::memory_order_relaxed) == 0) return;
+    h.event_futex.fetch_add(1, std::memory_order_relaxed);
+    shm_futex_wake(h.event_futex);
+}
+
+// ---------------------------------------------------------------------------
+// ShmClient
+
+ShmClient::ShmClient(const std::string& name, ShmWait wait, unsigned spin_polls)
+    : channel_(name, false), wait_(wait), spin_polls_(spin_polls) {
+    ShmHeader& h = channel_.header();
+    order_mask_  = h.order_slots - 1;
+    event_mask_  = h.event_slots - 1;
+    cursor_      = h.event_tail.load(std::memory_order_acquire);
+}
+
+void ShmClient::skip_lapped() {
+    // the writer is a full ring ahead; resume at the oldest slot it is not about to reuse
+    uint64_t tail     = channel_.header().event_tail.load(std::memory_order_acquire);
+    uint64_t capacity = event_mask_ + 1;
+    uint64_t resume   = tail > capacity ? tail - capacity + 1 : 0;
+    if (resume > cursor_) {
+        lost_  += resume - cursor_;
+        cursor_ = resume;
+    }
+}
+
+void ShmClient::idle() {
+    if (wait_ == ShmWait::SPIN || ++idle_polls_ < spin_polls_) {
+        cpu_relax();
+        return;
+    }
+
+    ShmHeader& h    = channel_.header();
+    uint32_t   seen = h.event_futex.load(std::memory_order_relaxed);
+    h.event_sleepers.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (h.event_tail.load(std::memory_order_acquire) <= cursor_) shm_futex_wait(h.event_futex, seen);
+
+    h.event_sleepers.fetch_sub(1, std::memory_order_relaxed);
+    idle_polls_ = 0;
+}
@@ -0,0 +1,190 @@
+#include "../include/snapshot.hpp"
+#include "../include/engine.hpp"
+#include "../include/journal.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char     SNAPSHOT_MAGIC[8] = {'O', 'B', 'S', 'N', 'A', 'P', '\0', '\1'};
+static const uint32_t SNAPSHOT_VERSION  = 5;
+
+template<typename T>
+static void put(std::vector<char>& out, const T& value) {
+    const char* p = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+std::vector<char> capture_snapshot(const Engine& engine) {
+    size_t orders = 0;
+    for (InstrumentId id = 0; id < engine.instrument_count(); id++) {
+        if (engine.book(id).in_auction())
+            throw std::logic_error("cannot snapshot " + engine.symbol_name(id) + " during a call auction");
+        orders += engine.book(id).order_count();
+    }
+
+    std::vector<char> image;
+    image.reserve(sizeof(SnapshotHeader)
+                  + engine.instrument_count() * sizeof(SnapshotBook)
+                  + orders * sizeof(SnapshotOrder));
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version          = SNAPSHOT_VERSION;
+    header.book_count       = (uint32_t)engine.instrument_count();
+    header.journal_sequence = engine.journal() ? engine.journal()->records() : 0;
+    header.order_count      = orders;
+    put(image, header);
+
+    for (InstrumentId id = 0; id < engine.instrument_count(); id++) {
+        const OrderBook&   book = engine.book(id);
+        const std::string& name = engine.symbol_name(id);
+
+        SnapshotBook record{};
+        if (name.size() >= sizeof(record.name))
+            throw std::invalid_argument("symbol too long for snapshot: " + name);
+        std::memcpy(record.name, name.data(), name.size());
+        record.mode      = (uint32_t)book.mode();
+        record.tick_size = book.config().tick_size;
+        record.min_price = book.config().min_price;
+        record.max_price = book.config().max_price;
+
+        size_t book_at = image.size();
+        put(image, record);
+
+        uint64_t counts[2] = {0, 0};
+        for (Side side : {Side::BUY, Side::SELL}) {
+            // walk nodes rather than orders: an iceberg's hidden reserve lives on the node
+            auto write_level = [&](const PriceLevel& level) {
+                for (const OrderNode* node = level.head(); node; node = node->next) {
+                    const Order&  order = node->order;
+                    SnapshotOrder out{};
+                    out.order_id         = order.order_id;
+                    out.timestamp        = order.timestamp;
+                    out.price            = order.price;
+                    out.quantity         = order.quantity;
+                    out.reserve          = node->reserve;
+                    out.display_quantity = order.display_quantity;
+                    out.account          = order.account;
+                    out.side             = (uint8_t)order.side;
+                    out.type             = (uint8_t)order.type;
+                    out.tif              = (uint8_t)order.tif;
+                    out.post_only        = order.post_only;
+                    put(image, out);
+                    ++counts[(int)side];
+                }
+                return true;
+            };
+            book.for_each_level(side, [&](Price, const PriceLevel& level) { return write_level(level); });
+            book.for_each_stop_level(side, [&](Price, const PriceLevel& level) { return write_level(level); });
+        }
+
+        auto* written = reinterpret_cast<SnapshotBook*>(image.data() + book_at);
+        written->bid_orders = counts[0];
+        written->ask_orders = counts[1];
+    }
+
+    return image;
+}
+
+void write_snapshot(const std::string& path, const std::vector<char>& image) {
+    std::string tmp = path + ".tmp";
+
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::runtime_error("cannot open " + tmp + ": " + std::strerror(errno));
+
+    const char* p    = image.data();
+    size_t      left = image.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ::close(fd);
+            throw std::runtime_error("snapshot write failed: " + std::string(std::strerror(errno)));
+        }
+        p    += n;
+        left -= (size_t)n;
+    }
+
+    if (::fsync(fd) != 0 || ::close(fd) != 0)
+        throw std::runtime_error("snapshot fsync failed: " + std::string(std::strerror(errno)));
+    if (std::rename(tmp.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("cannot rename " + tmp + ": " + std::strerror(errno));
+}
+
+std::future<void> save_snapshot_async(const Engine& engine, const std::string& path) {
+    return std::async(std::launch::async,
+                      [image = capture_snapshot(engine), path] { write_snapshot(path, image); });
+}
+
+uint64_t load_snapshot(const std::string& path, Engine& engine) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("cannot open snapshot " + path + ": " + std::strerror(errno));
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SnapshotHeader)) {
+        ::close(fd);
+        throw std::runtime_error("snapshot too short: " + path);
+    }
+    size_t length = (size_t)st.st_size;
+
+    void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) throw std::runtime_error("cannot mmap snapshot " + path);
+    ::madvise(mapping, length, MADV_SEQUENTIAL);
+
+    const char* p   = static_cast<const char*>(mapping);
+    const char* end = p + length;
+    auto fail = [&](const std::string& why) {
+        ::munmap(mapping, length);
+        throw std::runtime_error(why + ": " + path);
+    };
+
+    const auto* header = reinterpret_cast<const SnapshotHeader*>(p);
+    if (std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0
+        || header->version != SNAPSHOT_VERSION)
+        fail("not a snapshot or unsupported version");
+    p += sizeof(SnapshotHeader);
+    engine.pool().reserve(engine.pool().in_use() + header->order_count);
+
+    for (uint32_t b = 0; b < header->book_count; b++) {
+        if (end - p < (ptrdiff_t)sizeof(SnapshotBook)) fail("truncated snapshot");
+        const auto* book = reinterpret_cast<const SnapshotBook*>(p);
+        p += sizeof(SnapshotBook);
+
+        std::string      name(book->name, strnlen(book->name, sizeof(book->name)));
+        InstrumentConfig config{book->tick_size, book->min_price, book->max_price};
+        if ((BookMode)book->mode == BookMode::LADDER)
+            engine.add_symbol(name, config, BookMode::LADDER);
+        OrderBook& target = engine.book(engine.intern(name));
+
+        uint64_t count = book->bid_orders + book->ask_orders;
+        if ((uint64_t)(end - p) < count * sizeof(SnapshotOrder)) fail("truncated snapshot");
+
+        const auto* orders = reinterpret_cast<const SnapshotOrder*>(p);
+        for (uint64_t i = 0; i < count; i++) {
+            const SnapshotOrder& o = orders[i];
+            target.restore_order(Order{
+                .order_id         = o.order_id,
+                .price            = o.price,
+                .quantity         = o.quantity,
+                .account          = o.account,
+                .side             = (Side)o.side,
+                .type             = (OrderType)o.type,
+                .tif              = (TimeInForce)o.tif,
+                .post_only        = o.post_only != 0,
+                .display_quantity = o.display_quantity,
+                .timestamp        = o.timestamp
+            }, o.reserve);
+        }
+        p += count * sizeof(SnapshotOrder);
+    }
+
+    uint64_t sequence = header->journal_sequence;
+    ::munmap(mapping, length);
+    return sequence;
+}
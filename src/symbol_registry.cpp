@@ -0,0 +1,13 @@
+#include "../include/symbol_registry.hpp"
+
+InstrumentId SymbolRegistry::intern(const std::string& symbol) {
+    auto [it, inserted] = ids_.try_emplace(symbol, (InstrumentId)names_.size());
+    if (inserted) names_.push_back(symbol);
+    return it->second;
+}
+
+std::optional<InstrumentId> SymbolRegistry::find(const std::string& symbol) const {
+    auto it = ids_.find(symbol);
+    if (it == ids_.end()) return std::nullopt;
+    return it->second;
+}
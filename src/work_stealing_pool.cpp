@@ -0,0 +1,78 @@
+#include "../include/work_stealing_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+WorkStealingPool::WorkStealingPool(size_t threads)
+    : threads_(threads ? threads : std::max(1u, std::thread::hardware_concurrency())) {}
+
+void WorkStealingPool::run_erased(size_t count, const uint64_t* cost, void* ctx, void (*fn)(void*, size_t)) {
+    if (count == 0) return;
+
+    std::vector<size_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    if (cost) std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return cost[a] > cost[b]; });
+
+    // tasks[next..] are pending, biggest first; the owner takes from the front
+    // and thieves from the back
+    struct Deque {
+        std::mutex          lock;
+        std::vector<size_t> tasks;
+        size_t              next = 0;
+    };
+    const size_t       workers = std::min(threads_, count);
+    std::vector<Deque> deques(workers);
+    for (size_t k = 0; k < count; k++) deques[k % workers].tasks.push_back(order[k]);
+
+    std::atomic<bool>     failed{false};
+    std::atomic<uint64_t> steals{0};
+    std::mutex            error_lock;
+    std::exception_ptr    error;
+
+    auto take = [&](size_t w, size_t& task) {
+        {
+            Deque& own = deques[w];
+            std::lock_guard<std::mutex> guard(own.lock);
+            if (own.next < own.tasks.size()) {
+                task = own.tasks[own.next++];
+                return true;
+            }
+        }
+        for (size_t k = 1; k < workers; k++) {
+            Deque& victim = deques[(w + k) % workers];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (victim.next < victim.tasks.size()) {
+                task = victim.tasks.back();
+                victim.tasks.pop_back();
+                steals.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;  // the task set is fixed, so empty everywhere means done
+    };
+
+    auto work = [&](size_t w) {
+        size_t task;
+        while (!failed.load(std::memory_order_relaxed) && take(w, task)) {
+            try {
+                fn(ctx, task);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(error_lock);
+                if (!error) error = std::current_exception();
+                failed.store(true, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    std::vector<std::thread> helpers;
+    for (size_t w = 1; w < workers; w++) helpers.emplace_back(work, w);
+    work(0);
+    for (std::thread& helper : helpers) helper.join();
+
+    steals_ += steals.load();
+    if (error) std::rethrow_exception(error);
+}
@@ -0,0 +1,67 @@
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "../include/flow.hpp"
+#include "../include/gateway.hpp"
+
+// gateway <flow> [--port P] [--unix path] [--io-core C] [--match-core C] [--spin N]
+//         [--cancel-on-disconnect 0|1]
+//
+// Serves one Engine over the binary gateway protocol until SIGINT/SIGTERM.
+// The instruments are the SYMBOL records of a flow file, so a load generator
+// pointed at the same file addresses the same ids. Without --port or --unix
+// it listens on 127.0.0.1:9000.
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc % 2 != 0) {
+        std::cerr << "usage: " << argv[0] << " <flow> [--port P] [--unix path] [--io-core C] [--match-core C] [--spin N]"
+                     " [--cancel-on-disconnect 0|1]\n";
+        return 2;
+    }
+
+    GatewayOptions options;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if      (std::strcmp(argv[i], "--port") == 0)       options.tcp_port   = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--unix") == 0)       options.unix_path  = argv[i + 1];
+        else if (std::strcmp(argv[i], "--io-core") == 0)    options.io_core    = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--match-core") == 0) options.match_core = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--spin") == 0)       options.spin_polls = (unsigned)std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--cancel-on-disconnect") == 0)
+            options.cancel_on_disconnect = std::atoi(argv[i + 1]) != 0;
+        else {
+            std::cerr << "gateway: bad argument " << argv[i] << "\n";
+            return 2;
+        }
+    }
+    if (options.tcp_port < 0 && options.unix_path.empty()) options.tcp_port = 9000;
+
+    // block the signals before any thread starts, then wait for one here
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    try {
+        Engine engine;
+        load_flow(argv[1], engine);
+
+        Gateway gateway(engine, options);
+        gateway.start();
+        std::cout << "  serving " << engine.instrument_count() << " instruments on";
+        if (options.tcp_port >= 0)      std::cout << " 127.0.0.1:" << gateway.tcp_port();
+        if (!options.unix_path.empty()) std::cout << " " << options.unix_path;
+        std::cout << std::endl;
+
+        int signal = 0;
+        sigwait(&signals, &signal);
+        gateway.stop();
+        std::cout << "  stopped on signal " << signal << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "gateway: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}